@@ -11,8 +11,10 @@ def podConfig : NameMap String := Id.run $ do
   let mut cfg := NameMap.empty
   if let some cc := get_config? cc then
     cfg := cfg.insert `cc cc
+  -- `slab` only affects the bindings
   if let some alloc := get_config? alloc then
-    cfg := cfg.insert `alloc alloc
+    if alloc != "slab" then
+      cfg := cfg.insert `alloc alloc
   cfg
 
 -- Required for Float32, can be made standalone using a `def Float32 := UInt32`
@@ -28,11 +30,31 @@ package «yoga» {
   ]
 }
 
-lean_lib Yoga
+lean_lib Yoga {
+  globs := #[.andSubmodules `Yoga]
+}
 
 @[default_target]
 lean_exe Test
 
+/-- Run with `lake exe bench [workload-name-filters]`, prints results as JSON. -/
+lean_exe bench {
+  root := `Bench
+}
+
+/-- Run with `lake exe stress [options]`, flags style combinations whose layout cost grows superlinearly. -/
+lean_exe stress {
+  root := `Stress
+}
+
+/-- Run with `lake exe batch [options] [file]`, lays out a stream of serialized trees on worker threads. -/
+lean_exe batch {
+  root := `Batch
+}
+
+/-- Yoga publishes layout events only when built with this, see the `events` option. -/
+def yogaEventsFlag := if (get_config? events).isSome then " -DYG_ENABLE_EVENTS" else ""
+
 def tryRunProcess {m} [Monad m] [MonadError m] [MonadLiftT IO m] (sa : IO.Process.SpawnArgs) : m String := do
   let output ← IO.Process.output sa
   if output.exitCode ≠ 0 then
@@ -62,7 +84,7 @@ def buildYogaSubmodule (printCmdOutput : Bool) : IO Unit := do
       -- "-DCMAKE_POSITION_INDEPENDENT_CODE=ON",
       s!"-DCMAKE_C_COMPILER={cCompiler}",
       s!"-DCMAKE_CXX_COMPILER={cppCompiler}",
-      s!"-DCMAKE_CXX_FLAGS=-stdlib=lib{cppStdlib}",
+      s!"-DCMAKE_CXX_FLAGS=-stdlib=lib{cppStdlib}{yogaEventsFlag}",
       ".."
     ]
     cwd := __dir__ / "yoga" / "yoga" / "build"
@@ -94,9 +116,16 @@ extern_lib «yoga-lean» pkg := do
   match get_config? alloc with
   | .none | .some "lean" => pure ()
   | .some "native" => traceArgs := traceArgs.push "-DLEAN_YOGA_ALLOC_NATIVE"
+  | .some "slab" => traceArgs := traceArgs.push "-DLEAN_YOGA_ALLOC_SLAB"
   | .some _ => error "Unknown `alloc` option value"
   if (get_config? skipTests).isSome then
     traceArgs := traceArgs.push "-DLEAN_YOGA_SKIP_TESTS"
+  if (get_config? instrument).isSome then
+    traceArgs := traceArgs.push "-DLEAN_YOGA_INSTRUMENT"
+  if (get_config? trace).isSome then
+    traceArgs := traceArgs.push "-DLEAN_YOGA_TRACE"
+  if (get_config? events).isSome then
+    traceArgs := traceArgs.push "-DLEAN_YOGA_EVENTS"
 
   let cCompiler ←
     if cCompiler == "clang"
@@ -112,7 +141,10 @@ extern_lib «yoga-lean» pkg := do
   let fileName := "ffi.c"
   let srcJob ← inputFile <| pkg.dir / "src" / "native" / fileName
   let ffiO ← buildO ("native/" ++ fileName) oFile srcJob weakArgs traceArgs cCompiler
-  buildStaticLib (pkg.nativeLibDir / name) #[ffiO]
+  let internalSrcJob ← inputFile <| pkg.dir / "src" / "native" / "internal.cpp"
+  let internalO ← buildO "native/internal.cpp" (pkg.irDir / "native" / "internal.o") internalSrcJob
+    weakArgs (traceArgs ++ #["-std=c++17", s!"-stdlib=lib{cppStdlib}"]) cppCompiler
+  buildStaticLib (pkg.nativeLibDir / name) #[ffiO, internalO]
 
 script buildSubmodule do
   buildYogaSubmodule true
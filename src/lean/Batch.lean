@@ -0,0 +1,149 @@
+import Yoga
+
+open Yoga
+
+structure Options where
+  workers : Nat := 4
+  /-- Documents read ahead of the first one whose result isn't written yet. -/
+  window : Nat := 256
+  input : Option System.FilePath := none
+
+/-- The encoded layout of a document or why it failed, and the nanoseconds it took. -/
+structure Outcome where
+  result : Except String ByteArray
+  nanos : Nat
+
+def layoutBytes (config : Config Unit Unit) (data : ByteArray) : IO ByteArray := do
+  let root ← Node.deserialize data () config
+  root.calculateLayout undefined undefined .ltr
+  root.encodeLayout
+
+/-- Rebuilds, lays out and encodes one document, every worker using its own config. -/
+def layoutDocument (config : Config Unit Unit) (data : ByteArray) : IO Outcome := do
+  let start ← IO.monoNanosNow
+  let result ← (layoutBytes config data).toBaseIO
+  let stop ← IO.monoNanosNow
+  pure { result := result.mapError toString, nanos := stop - start }
+
+/--
+Starts `workers` threads which live until `jobs` is closed, each with its own config,
+taking the next numbered document from `jobs` once done with one and sending its outcome to `results`.
+-/
+def startWorkers (workers : Nat) (jobs : IO.Channel (Nat × ByteArray)) (results : IO.Channel (Nat × Outcome)) :
+    IO (Array (Task (Except IO.Error Unit))) :=
+  (List.range (max workers 1)).toArray.mapM fun _ => IO.asTask (prio := .dedicated) do
+    let config : Config Unit Unit ← Config.new ()
+    repeat
+      let some (i, data) ← jobs.sync.recv? | break
+      results.send (i, ← layoutDocument config data)
+
+def u32Bytes (x : Nat) : ByteArray :=
+  ⟨#[x.toUInt8, (x >>> 8).toUInt8, (x >>> 16).toUInt8, (x >>> 24).toUInt8]⟩
+
+def readU32 (bytes : ByteArray) : Nat :=
+  (bytes.get! 0).toNat ||| ((bytes.get! 1).toNat <<< 8) |||
+    ((bytes.get! 2).toNat <<< 16) ||| ((bytes.get! 3).toNat <<< 24)
+
+/-- Reads `n` bytes, fewer only at the end of the stream. -/
+partial def readExact (stream : IO.FS.Stream) (n : Nat) (acc : ByteArray := .empty) : IO ByteArray := do
+  if acc.size ≥ n then
+    return acc
+  let chunk ← stream.read (n - acc.size).toUSize
+  if chunk.size == 0 then
+    return acc
+  readExact stream n (acc ++ chunk)
+
+/-- The next frame, a little-endian `u32` length and that many bytes, or none at the end of the stream. -/
+def readFrame (stream : IO.FS.Stream) : IO (Option ByteArray) := do
+  let header ← readExact stream 4
+  if header.size == 0 then
+    return none
+  if header.size < 4 then
+    throw (IO.userError "truncated frame length")
+  let size := readU32 header
+  let data ← readExact stream size
+  if data.size < size then
+    throw (IO.userError "truncated frame")
+  pure (some data)
+
+/-- A result frame: `u32` payload length, `u8` status (0 for layout, 1 for error message), payload. -/
+def resultFrame (outcome : Outcome) : ByteArray :=
+  let (status, payload) : UInt8 × ByteArray := match outcome.result with
+    | .ok layout => (0, layout)
+    | .error message => (1, message.toUTF8)
+  u32Bytes payload.size ++ ⟨#[status]⟩ ++ payload
+
+def percentile (sorted : Array Nat) (p : Nat) : Nat :=
+  if sorted.isEmpty then 0 else sorted[min (sorted.size - 1) (p * sorted.size / 100)]!
+
+def natArg (name value : String) : Except String Nat :=
+  match value.toNat? with
+  | some n => if n == 0 then throw s!"'{name}' must be positive" else pure n
+  | none => throw s!"'{name}' expects a natural number, got '{value}'"
+
+partial def parseArgs (opts : Options) : List String → Except String Options
+| [] => pure opts
+| "--workers" :: n :: rest => do parseArgs { opts with workers := ← natArg "--workers" n } rest
+| "--window" :: n :: rest => do parseArgs { opts with window := ← natArg "--window" n } rest
+| "-" :: rest => parseArgs { opts with input := none } rest
+| path :: rest =>
+  if path.startsWith "--"
+    then throw s!"unknown or incomplete argument '{path}'"
+    else parseArgs { opts with input := some ⟨path⟩ } rest
+
+/--
+Lays out a stream of trees written by `Node.serialize`, each in a length-prefixed frame,
+and writes a frame with the `Node.encodeLayout` of each to stdout in input order.
+Trees are laid out with an undefined owner size, so roots should have their size set.
+Throughput and per-document latency percentiles go to stderr as JSON. Exits with 1 if a document failed.
+
+`lake exe batch [--workers n] [--window documents] [file | -]`
+-/
+def main (args : List String) : IO UInt32 := do
+  let opts ← IO.ofExcept (parseArgs {} args)
+  let input ← match opts.input with
+    | some path => IO.FS.Stream.ofHandle <$> IO.FS.Handle.mk path .read
+    | none => IO.getStdin
+  let output ← IO.getStdout
+  let jobs : IO.Channel (Nat × ByteArray) ← IO.Channel.new
+  let results : IO.Channel (Nat × Outcome) ← IO.Channel.new
+  let workers ← startWorkers opts.workers jobs results
+  let start ← IO.monoNanosNow
+  let mut latencies : Array Nat := #[]
+  let mut failures := 0
+  -- Outcomes which arrived before those of earlier documents, at their index modulo the window
+  let mut reorder : Array (Option Outcome) := mkArray opts.window none
+  let mut read := 0
+  let mut written := 0
+  let mut ended := false
+  repeat
+    while !ended && read - written < opts.window do
+      match ← readFrame input with
+      | some frame =>
+        jobs.send (read, frame)
+        read := read + 1
+      | none => ended := true
+    if written == read then
+      break
+    let some (i, outcome) ← results.sync.recv? | throw (IO.userError "workers stopped")
+    reorder := reorder.set! (i % opts.window) (some outcome)
+    repeat
+      let some outcome := reorder[written % opts.window]! | break
+      reorder := reorder.set! (written % opts.window) none
+      written := written + 1
+      latencies := latencies.push outcome.nanos
+      if outcome.result matches .error _ then
+        failures := failures + 1
+      output.write (resultFrame outcome)
+    output.flush
+  jobs.close
+  for worker in workers do
+    IO.ofExcept (← IO.wait worker)
+  let elapsed := (← IO.monoNanosNow) - start
+  let sorted := latencies.qsort (· < ·)
+  IO.eprintln <|
+    s!"\{\"documents\": {sorted.size}, \"failures\": {failures}, \"workers\": {opts.workers}, " ++
+    s!"\"documentsPerSecond\": {sorted.size.toFloat * 1e9 / (max elapsed 1).toFloat}, " ++
+    s!"\"latencyNanos\": \{\"p50\": {percentile sorted 50}, \"p90\": {percentile sorted 90}, " ++
+    s!"\"p99\": {percentile sorted 99}, \"max\": {sorted.back?.getD 0}}}"
+  return if failures == 0 then 0 else 1
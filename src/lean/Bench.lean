@@ -0,0 +1,291 @@
+import Yoga
+
+open Pod (Float32)
+open Yoga
+
+abbrev BNode := Node Unit Unit
+
+structure Workload where
+  name : String
+  iterations : Nat
+  /-- Build the tree, returning the root and the number of nodes an iteration lays out. -/
+  setup : Config Unit Unit → IO (BNode × Nat)
+  run : Config Unit Unit → BNode → (iteration : Nat) → IO Unit
+  /-- Bytes an iteration encodes or decodes, reported as throughput if not zero. -/
+  bytes : BNode → IO Nat := fun _ => pure 0
+  /-- Remove what `setup` left outside the tree, e.g. files. -/
+  teardown : IO Unit := pure ()
+
+structure Result where
+  name : String
+  nodes : Nat
+  iterations : Nat
+  nanos : Nat
+  allocations : Nat
+  bytes : Nat
+
+def Result.toJson (r : Result) : String :=
+  let nsPerIteration := r.nanos.toFloat / r.iterations.toFloat
+  let nsPerNode := nsPerIteration / (max r.nodes 1).toFloat
+  let allocations := r.allocations.toFloat / r.iterations.toFloat
+  s!"\{\"name\": \"{r.name}\", \"nodes\": {r.nodes}, \"iterations\": {r.iterations}, " ++
+  s!"\"nsPerIteration\": {nsPerIteration}, \"nsPerNode\": {nsPerNode}, " ++
+  let throughput :=
+    if r.bytes == 0 then ""
+    else s!", \"megabytesPerSecond\": {r.bytes.toFloat * 1e3 / nsPerIteration}"
+  s!"\"allocationsPerIteration\": {allocations}{throughput}}"
+
+/-- Alternating owner widths force a relayout of everything depending on the root's width. -/
+def relayout (root : BNode) (i : Nat) : IO Unit := do
+  root.styleSetWidth (if i % 2 == 0 then 1000 else 999)
+  root.calculateLayout undefined undefined .ltr
+
+def leaf (cfg : Config Unit Unit) (width height : Float32) : IO BNode := do
+  let node ← Node.newWithConfig () cfg
+  node.styleSetWidth width
+  node.styleSetHeight height
+  pure node
+
+def deepChain (depth : Nat) : Workload where
+  name := s!"deepChain{depth}"
+  iterations := 100
+  setup cfg := do
+    let root ← Node.newWithConfig () cfg
+    let mut parent := root
+    for _ in [1:depth] do
+      let child ← Node.newWithConfig () cfg
+      child.styleSetPadding .all 1
+      parent.insertChild child 0
+      parent := child
+    parent.styleSetHeight 10
+    pure (root, depth)
+  run _ root i := relayout root i
+
+def wideList (width : Nat) : Workload where
+  name := s!"wideList{width}"
+  iterations := 50
+  setup cfg := do
+    let root ← Node.newWithConfig () cfg
+    let children ← (List.range width).toArray.mapM fun _ => do
+      let child ← Node.newWithConfig () cfg
+      child.styleSetHeight 20
+      child.styleSetMargin .all 1
+      pure child
+    root.insertChildren children 0
+    pure (root, width + 1)
+  run _ root i := relayout root i
+
+def wrapGrid (rows columns : Nat) : Workload where
+  name := s!"wrapGrid{rows}x{columns}"
+  iterations := 50
+  setup cfg := do
+    let root ← Node.newWithConfig () cfg
+    root.styleSetFlexDirection .row
+    root.styleSetFlexWrap .wrap
+    for i in [0:rows] do
+      let row ← Node.newWithConfig () cfg
+      row.styleSetFlexDirection .row
+      row.styleSetFlexWrap .wrap
+      row.styleSetWidthPercent 50
+      row.insertChildren (← (List.range columns).toArray.mapM fun _ => leaf cfg 30 30) 0
+      root.insertChild row i.toUInt32
+    pure (root, 1 + rows * (columns + 1))
+  run _ root i := relayout root i
+
+partial def percentSubtree (cfg : Config Unit Unit) (depth fanout : Nat) : IO (BNode × Nat) := do
+  let node ← Node.newWithConfig () cfg
+  node.styleSetFlexDirection (if depth % 2 == 0 then .row else .column)
+  node.styleSetWidthPercent 90
+  node.styleSetHeightPercent 90
+  node.styleSetPaddingPercent .all 2
+  node.styleSetMarginPercent .all 1
+  let mut count := 1
+  if depth > 0 then
+    for i in [0:fanout] do
+      let (child, n) ← percentSubtree cfg (depth - 1) fanout
+      node.insertChild child i.toUInt32
+      count := count + n
+  pure (node, count)
+
+def percentTree (depth fanout : Nat) : Workload where
+  name := s!"percentTree{depth}x{fanout}"
+  iterations := 50
+  setup cfg := do
+    let (root, count) ← percentSubtree cfg depth fanout
+    root.styleSetHeight 1000
+    pure (root, count)
+  run _ root i := relayout root i
+
+def measureLeaves (count : Nat) : Workload where
+  name := s!"measureLeaves{count}"
+  iterations := 50
+  setup cfg := do
+    let root ← Node.newWithConfig () cfg
+    root.styleSetFlexDirection .row
+    root.styleSetFlexWrap .wrap
+    let leaves ← (List.range count).toArray.mapM fun _ => do
+      let text ← Node.newWithConfig () cfg
+      text.setNodeType .text
+      text.setMeasureFunc fun _ width widthMode _ _ =>
+        pure { width := if widthMode == .undefined || width > 40 then 40 else width, height := 12 }
+      pure text
+    root.insertChildren leaves 0
+    pure (root, count + 1)
+  run _ root i := relayout root i
+
+def buildTree (cfg : Config Unit Unit) (width height : Nat) : IO BNode := do
+  let root ← Node.newWithConfig () cfg
+  for i in [0:width] do
+    let column ← Node.newWithConfig () cfg
+    column.styleSetFlexGrow 1
+    for j in [0:height] do
+      column.insertChild (← leaf cfg 10 10) j.toUInt32
+    root.insertChild column i.toUInt32
+  pure root
+
+def buildTeardown (width height : Nat) : Workload where
+  name := s!"buildTeardown{width}x{height}"
+  iterations := 20
+  setup cfg := do
+    pure (← Node.newWithConfig () cfg, 1 + width * (height + 1))
+  run cfg _ _ := do
+    let root ← buildTree cfg width height
+    root.styleSetFlexDirection .row
+    root.calculateLayout undefined undefined .ltr
+
+def styleMutation (width height : Nat) : Workload where
+  name := s!"styleMutation{width}x{height}"
+  iterations := 200
+  setup cfg := do
+    let root ← buildTree cfg width height
+    root.styleSetFlexDirection .row
+    root.calculateLayout undefined undefined .ltr
+    pure (root, 1 + width * (height + 1))
+  run _ root i := do
+    if let some column ← root.getChild? (i % width).toUInt32 then
+      if let some target ← column.getChild? (i % height).toUInt32 then
+        target.styleSetWidth (if (i / width) % 2 == 0 then 12 else 10)
+    root.calculateLayout undefined undefined .ltr
+
+/-- Replaces a tenth of the children with small fresh subtrees, churning contexts and children arrays. -/
+def childChurn (width : Nat) : Workload where
+  name := s!"childChurn{width}"
+  iterations := 100
+  setup cfg := do
+    let root ← Node.newWithConfig () cfg
+    root.styleSetFlexDirection .row
+    root.styleSetFlexWrap .wrap
+    root.insertChildren (← (List.range width).toArray.mapM fun _ => leaf cfg 10 10) 0
+    pure (root, width + 1)
+  run cfg root i := do
+    for j in [0:width / 10] do
+      let index := ((i * 7 + j * 13) % width).toUInt32
+      root.removeChildAt index
+      let container ← Node.newWithConfig () cfg
+      for k in [0:j % 4 + 1] do
+        container.insertChild (← leaf cfg 5 5) k.toUInt32
+      root.insertChild container index
+    root.calculateLayout undefined undefined .ltr
+
+def coldStartPath (name : String) : System.FilePath := s!"bench-{name}.bin"
+
+/--
+Cold start of a `buildTree` document laid out for a fixed window, from the file written by `save`
+to a laid out tree.
+-/
+def coldStart (name : String) (width height : Nat)
+    (save : BNode → System.FilePath → IO Unit) (load : System.FilePath → Config Unit Unit → IO BNode) :
+    Workload where
+  name := s!"{name}{width}x{height}"
+  iterations := 20
+  setup cfg := do
+    let root ← buildTree cfg width height
+    root.styleSetFlexDirection .row
+    save root (coldStartPath name)
+    pure (root, 1 + width * (height + 1))
+  run cfg _ _ := do
+    let root ← load (coldStartPath name) cfg
+    root.calculateLayout 1000 undefined .ltr
+  teardown := IO.FS.removeFile (coldStartPath name)
+
+def coldStartLayout (width height : Nat) : Workload :=
+  coldStart "coldStartLayout" width height
+    (fun root path => do IO.FS.writeBinFile path (← root.serialize))
+    (fun path cfg => do Node.deserialize (← IO.FS.readBinFile path) () cfg)
+
+def coldStartSnapshot (width height : Nat) : Workload :=
+  coldStart "coldStartSnapshot" width height
+    (fun root path => root.saveSnapshot path 1000 undefined .ltr)
+    (fun path cfg => Node.loadSnapshot path () cfg)
+
+def serializeTree (width height : Nat) : Workload where
+  name := s!"serialize{width}x{height}"
+  iterations := 20
+  setup cfg := do
+    let root ← buildTree cfg width height
+    root.calculateLayout undefined undefined .ltr
+    pure (root, 1 + width * (height + 1))
+  run _ root _ := do
+    let _ ← root.serialize (withLayout := true)
+  bytes root := return (← root.serialize (withLayout := true)).size
+
+/-- Decodes the tree `setup` encoded into `encoded`. -/
+def deserializeTree (encoded : IO.Ref ByteArray) (width height : Nat) : Workload where
+  name := s!"deserialize{width}x{height}"
+  iterations := 20
+  setup cfg := do
+    let root ← buildTree cfg width height
+    root.calculateLayout undefined undefined .ltr
+    encoded.set (← root.serialize (withLayout := true))
+    pure (root, 1 + width * (height + 1))
+  run cfg _ _ := do
+    let _ ← Node.deserialize (← encoded.get) () cfg
+  bytes _ := return (← encoded.get).size
+
+def workloads : IO (List Workload) := do
+  let encoded ← IO.mkRef ByteArray.empty
+  pure [
+    deepChain 1000,
+    wideList 10000,
+    wrapGrid 100 50,
+    percentTree 5 4,
+    measureLeaves 2000,
+    buildTeardown 100 100,
+    styleMutation 100 100,
+    childChurn 1000,
+    coldStartLayout 100 100,
+    coldStartSnapshot 100 100,
+    serializeTree 100 1000,
+    deserializeTree encoded 100 1000
+  ]
+
+def Workload.measure (w : Workload) (cfg : Config Unit Unit) : IO Result := do
+  let (root, nodes) ← w.setup cfg
+  for i in [0:3] do
+    w.run cfg root i
+  let allocationsBefore ← getAllocationCount
+  let start ← IO.monoNanosNow
+  for i in [0:w.iterations] do
+    w.run cfg root (i + 1)
+  let stop ← IO.monoNanosNow
+  let allocationsAfter ← getAllocationCount
+  let bytes ← w.bytes root
+  w.teardown
+  pure {
+    name := w.name
+    nodes := nodes
+    iterations := w.iterations
+    nanos := stop - start
+    allocations := (allocationsAfter - allocationsBefore).toNat
+    bytes := bytes
+  }
+
+/-- Runs all workloads, or only those whose names contain one of the arguments, printing JSON. -/
+def main (args : List String) : IO Unit := do
+  let cfg ← Config.new ()
+  let selected := (← workloads).filter fun w =>
+    args.isEmpty || args.any fun arg => (w.name.splitOn arg).length > 1
+  let mut results := #[]
+  for w in selected do
+    results := results.push (← w.measure cfg)
+  IO.println s!"\{\"benchmarks\": [{", ".intercalate (results.toList.map Result.toJson)}]}"
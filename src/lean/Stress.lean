@@ -0,0 +1,316 @@
+import Yoga
+
+open Pod (Float32)
+open Yoga
+
+abbrev SNode := Node Unit Unit
+
+/-- Style features the generator combines, the ones known to interact badly are percentages,
+wrapping and measured leaves. -/
+inductive Feature where
+| percent | wrap | measure | grow | minMax | aspectRatio | baseline | absolute
+deriving Inhabited, BEq
+
+def Feature.all : Array Feature :=
+  #[.percent, .wrap, .measure, .grow, .minMax, .aspectRatio, .baseline, .absolute]
+
+def Feature.name : Feature → String
+| .percent => "percent"
+| .wrap => "wrap"
+| .measure => "measure"
+| .grow => "grow"
+| .minMax => "minMax"
+| .aspectRatio => "aspectRatio"
+| .baseline => "baseline"
+| .absolute => "absolute"
+
+def Feature.ofName? (name : String) : Option Feature :=
+  Feature.all.find? (·.name == name)
+
+def featuresToJson (features : Array Feature) : String :=
+  "[" ++ ", ".intercalate (features.toList.map fun f => s!"\"{f.name}\"") ++ "]"
+
+/-- Every feature alone, every pair, and all of them together. -/
+def defaultCombinations : Array (Array Feature) := Id.run do
+  let mut result := Feature.all.map (#[·])
+  for i in [0:Feature.all.size] do
+    for j in [i + 1:Feature.all.size] do
+      result := result.push #[Feature.all[i]!, Feature.all[j]!]
+  result.push Feature.all
+
+/-- A paragraph of fixed length wrapping at the available width, counting its calls. -/
+def textMeasure (calls : IO.Ref Nat) : MeasureFunc Unit Unit := fun _ width widthMode _ _ => do
+  calls.modify (· + 1)
+  let natural : Float32 := 280
+  let lineWidth : Float32 :=
+    if widthMode == .undefined || natural < width then natural
+    else if width < 7 then 7 else width
+  let mut lines : Float32 := 1
+  let mut rest := natural - lineWidth
+  while 0 < rest do
+    lines := lines + 1
+    rest := rest - lineWidth
+  pure { width := lineWidth, height := 12 * lines }
+
+abbrev GenM := StateT StdGen IO
+
+def rand (lo hi : Nat) : GenM Nat :=
+  modifyGet fun gen => randNat gen lo hi
+
+def chance (percent : Nat) : GenM Bool :=
+  return (← rand 0 99) < percent
+
+def pick (values : Array Float32) : GenM Float32 :=
+  return values[← rand 0 (values.size - 1)]!
+
+structure Generator where
+  config : Config Unit Unit
+  features : Array Feature
+  measureCalls : IO.Ref Nat
+
+def Generator.has (g : Generator) (feature : Feature) : Bool :=
+  g.features.contains feature
+
+/-- Styles of the node as an item of its parent. -/
+def Generator.styleItem (g : Generator) (node : SNode) : GenM Unit := do
+  if g.has .percent && (← chance 40) then
+    node.styleSetMarginPercent .all (← pick #[1, 2, 5])
+  if g.has .grow then
+    node.styleSetFlexGrow (← pick #[0, 1, 2])
+    node.styleSetFlexShrink (← pick #[0, 1])
+    if (← chance 30) then
+      if g.has .percent
+        then node.styleSetFlexBasisPercent (← pick #[10, 25, 50])
+        else node.styleSetFlexBasis (← pick #[10, 50, 100])
+  if g.has .minMax && (← chance 40) then
+    node.styleSetMinWidth (← pick #[5, 20, 60])
+    if g.has .percent
+      then node.styleSetMaxWidthPercent (← pick #[30, 60, 90])
+      else node.styleSetMaxWidth (← pick #[100, 200, 400])
+  if g.has .aspectRatio && (← chance 30) then
+    node.styleSetAspectRatio (← pick #[1, 2, 3])
+  if g.has .absolute && (← chance 10) then
+    node.styleSetPositionType .absolute
+    if g.has .percent
+      then node.styleSetPositionPercent .left (← pick #[0, 10, 50])
+      else node.styleSetPosition .left (← pick #[0, 10, 50])
+
+def Generator.leaf (g : Generator) : GenM SNode := do
+  let node ← Node.newWithConfig () g.config
+  if g.has .measure && (← chance 70) then
+    node.setNodeType .text
+    node.setMeasureFunc (textMeasure g.measureCalls)
+  else
+    node.styleSetWidth (← pick #[10, 20, 40])
+    node.styleSetHeight (← pick #[10, 20, 40])
+  g.styleItem node
+  pure node
+
+/-- A random subtree of exactly `budget` nodes, nested at most `depth` levels. -/
+def Generator.subtree (g : Generator) : (depth budget : Nat) → GenM SNode
+| 0, _ => g.leaf
+| depth + 1, budget => do
+  if budget ≤ 1 then
+    return ← g.leaf
+  let node ← Node.newWithConfig () g.config
+  node.styleSetFlexDirection (if (← chance 50) then .row else .column)
+  if g.has .wrap && (← chance 50) then
+    node.styleSetFlexWrap .wrap
+  if g.has .baseline && (← chance 50) then
+    node.styleSetAlignItems .baseline
+  if g.has .percent && (← chance 60) then
+    node.styleSetWidthPercent (← pick #[50, 80, 100])
+    if (← chance 50) then
+      node.styleSetHeightPercent (← pick #[50, 80, 100])
+    node.styleSetPaddingPercent .all (← pick #[1, 2, 5])
+  g.styleItem node
+  let fanout ← rand 1 (min 6 (budget - 1))
+  let share := (budget - 1) / fanout
+  let extra := (budget - 1) % fanout
+  for i in [0:fanout] do
+    let child ← g.subtree depth (share + if i < extra then 1 else 0)
+    node.insertChild child i.toUInt32
+  pure node
+
+/-- The tree of `size` nodes which the seed generates for the features. -/
+def generate (config : Config Unit Unit) (features : Array Feature) (measureCalls : IO.Ref Nat)
+  (seed size : Nat) : IO SNode :=
+    let g : Generator := { config := config, features := features, measureCalls := measureCalls }
+    (g.subtree size size).run' (mkStdGen seed)
+
+structure Sample where
+  nodes : Nat
+  nanos : Nat
+  measureCalls : Nat
+
+/-- Best time of `repeats` full layouts, each after dirtying the whole tree, and the measure calls of one. -/
+def timeLayout (root : SNode) (measureCalls : IO.Ref Nat) (nodes repeats : Nat) : IO Sample := do
+  let mut best := 0
+  let mut calls := 0
+  for i in [0:max repeats 1] do
+    root.markDirtyAndPropagateToDescendants
+    root.styleSetWidth (if i % 2 == 0 then 1000 else 999)
+    measureCalls.set 0
+    let start ← IO.monoNanosNow
+    root.calculateLayout undefined undefined .ltr
+    let nanos := (← IO.monoNanosNow) - start
+    best := if i == 0 then nanos else min best nanos
+    calls ← measureCalls.get
+  pure { nodes := nodes, nanos := best, measureCalls := calls }
+
+/-- Least squares slope of `log y` over `log x`, the exponent `k` of `y ~ x^k`. -/
+def growthExponent (points : Array (Nat × Nat)) : Float :=
+  let logs := points.map fun (x, y) => ((max x 1).toFloat.log, (max y 1).toFloat.log)
+  let n := logs.size.toFloat
+  let sx := logs.foldl (fun acc (x, _) => acc + x) 0
+  let sy := logs.foldl (fun acc (_, y) => acc + y) 0
+  let sxx := logs.foldl (fun acc (x, _) => acc + x * x) 0
+  let sxy := logs.foldl (fun acc (x, y) => acc + x * y) 0
+  let denominator := n * sxx - sx * sx
+  if denominator == 0 then 0 else (n * sxy - sx * sy) / denominator
+
+structure Sweep where
+  features : Array Feature
+  samples : Array Sample
+  timeExponent : Float
+  measureExponent : Float
+
+def Sweep.ofSamples (features : Array Feature) (samples : Array Sample) : Sweep where
+  features := features
+  samples := samples
+  timeExponent := growthExponent (samples.map fun s => (s.nodes, s.nanos))
+  measureExponent := growthExponent (samples.map fun s => (s.nodes, s.measureCalls))
+
+/-- At least three sizes are needed for the fit to mean anything. -/
+def Sweep.superlinear (s : Sweep) (threshold : Float) : Bool :=
+  s.samples.size ≥ 3 && (s.timeExponent > threshold || s.measureExponent > threshold)
+
+def Sweep.toJson (s : Sweep) (threshold : Float) (repro : Option (Array Feature × System.FilePath)) : String :=
+  let samples := s.samples.toList.map fun sample =>
+    s!"\{\"nodes\": {sample.nodes}, \"nanos\": {sample.nanos}, \"measureCalls\": {sample.measureCalls}}"
+  let repro := match repro with
+    | some (features, path) => s!", \"minimalFeatures\": {featuresToJson features}, \"repro\": \"{path}\""
+    | none => ""
+  s!"\{\"features\": {featuresToJson s.features}, \"samples\": [{", ".intercalate samples}], " ++
+  s!"\"timeExponent\": {s.timeExponent}, \"measureExponent\": {s.measureExponent}, " ++
+  s!"\"superlinear\": {s.superlinear threshold}{repro}}"
+
+structure Options where
+  seed : Nat := 1
+  sizes : Array Nat := #[100, 200, 400, 800, 1600, 3200]
+  repeats : Nat := 3
+  /-- Growth exponent above which a configuration is flagged. -/
+  threshold : Float := 1.25
+  /-- A sweep stops growing once a layout takes longer. -/
+  maxNanos : Nat := 2000000000
+  features : Option (Array Feature) := none
+  outDir : System.FilePath := ⟨"."⟩
+  repro : Option System.FilePath := none
+
+def Options.sweep (opts : Options) (config : Config Unit Unit) (features : Array Feature) : IO Sweep := do
+  let measureCalls ← IO.mkRef 0
+  let mut samples := #[]
+  for size in opts.sizes do
+    let root ← generate config features measureCalls opts.seed size
+    let sample ← timeLayout root measureCalls size opts.repeats
+    samples := samples.push sample
+    if sample.nanos > opts.maxNanos then
+      break
+  pure (Sweep.ofSamples features samples)
+
+/--
+Drops features one by one while the growth stays superlinear,
+then finds the smallest size whose sweep up to it still shows it.
+-/
+def Options.minimize (opts : Options) (config : Config Unit Unit) (sweep : Sweep) : IO (Array Feature × Nat) := do
+  let mut kept := sweep.features
+  for feature in sweep.features do
+    let candidate := kept.filter (· != feature)
+    if candidate.isEmpty then
+      continue
+    if (← opts.sweep config candidate).superlinear opts.threshold then
+      kept := candidate
+  let final ← opts.sweep config kept
+  let mut size := final.samples.back?.map (·.nodes) |>.getD 0
+  for k in [3:final.samples.size + 1] do
+    let samples := final.samples.extract 0 k
+    if (Sweep.ofSamples kept samples).superlinear opts.threshold then
+      size := samples.back?.map (·.nodes) |>.getD size
+      break
+  pure (kept, size)
+
+/-- Writes the generated tree with `Node.serialize`, reload it with `--repro`. -/
+def Options.writeRepro (opts : Options) (config : Config Unit Unit) (features : Array Feature) (size : Nat) :
+    IO System.FilePath := do
+  let root ← generate config features (← IO.mkRef 0) opts.seed size
+  let name := "-".intercalate (features.toList.map Feature.name)
+  let path := opts.outDir / s!"stress-{name}-seed{opts.seed}-{size}.yoga"
+  IO.FS.writeBinFile path (← root.serialize)
+  pure path
+
+/-- Loads a tree written by `Options.writeRepro`, text nodes get the generator's measure function back. -/
+def loadRepro (config : Config Unit Unit) (measureCalls : IO.Ref Nat) (path : System.FilePath) :
+    IO (SNode × Nat) := do
+  let root ← Node.deserialize (← IO.FS.readBinFile path) () config
+  let nodes ← root.toPreorderArray
+  for node in nodes do
+    if (← node.getNodeType) == .text then
+      node.setMeasureFunc (textMeasure measureCalls)
+  pure (root, nodes.size)
+
+def natArg (name value : String) : Except String Nat :=
+  match value.toNat? with
+  | some n => pure n
+  | none => throw s!"'{name}' expects a natural number, got '{value}'"
+
+/-- Sizes doubling from 100 up to `max`. -/
+partial def sizesUpTo (max : Nat) (size : Nat := 100) (sizes : Array Nat := #[]) : Array Nat :=
+  if size > max then sizes else sizesUpTo max (2 * size) (sizes.push size)
+
+partial def parseArgs (opts : Options) : List String → Except String Options
+| [] => pure opts
+| "--seed" :: n :: rest => do parseArgs { opts with seed := ← natArg "--seed" n } rest
+| "--max" :: n :: rest => do parseArgs { opts with sizes := sizesUpTo (← natArg "--max" n) } rest
+| "--repeats" :: n :: rest => do parseArgs { opts with repeats := ← natArg "--repeats" n } rest
+| "--threshold" :: n :: rest => do
+  parseArgs { opts with threshold := (← natArg "--threshold" n).toFloat / 100 } rest
+| "--features" :: names :: rest => do
+  let features ← (names.splitOn ",").toArray.mapM fun name =>
+    match Feature.ofName? name with
+    | some feature => pure feature
+    | none => throw s!"unknown feature '{name}'"
+  parseArgs { opts with features := some features } rest
+| "--out" :: dir :: rest => parseArgs { opts with outDir := ⟨dir⟩ } rest
+| "--repro" :: path :: rest => parseArgs { opts with repro := some ⟨path⟩ } rest
+| arg :: _ => throw s!"unknown or incomplete argument '{arg}'"
+
+/--
+Sweeps random trees of growing sizes for combinations of style features, printing one JSON object per line.
+Configurations whose layout time or measure calls grow faster than `nodes ^ threshold` are flagged,
+minimized and written as a tree which `--repro` loads and times again. Exits with 1 if any was flagged.
+
+`lake exe stress [--seed n] [--max nodes] [--repeats n] [--threshold percent]
+  [--features a,b] [--out dir] [--repro file]`
+-/
+def main (args : List String) : IO UInt32 := do
+  let opts ← IO.ofExcept (parseArgs {} args)
+  let config ← Config.new ()
+  if let some path := opts.repro then
+    let measureCalls ← IO.mkRef 0
+    let (root, nodes) ← loadRepro config measureCalls path
+    let sample ← timeLayout root measureCalls nodes opts.repeats
+    IO.println <|
+      s!"\{\"repro\": \"{path}\", \"nodes\": {sample.nodes}, " ++
+      s!"\"nanos\": {sample.nanos}, \"measureCalls\": {sample.measureCalls}}"
+    return 0
+  let combinations := (opts.features.map (#[·])).getD defaultCombinations
+  let mut flagged := 0
+  for features in combinations do
+    let sweep ← opts.sweep config features
+    let mut repro : Option (Array Feature × System.FilePath) := none
+    if sweep.superlinear opts.threshold then
+      flagged := flagged + 1
+      let (minimal, size) ← opts.minimize config sweep
+      repro := some (minimal, ← opts.writeRepro config minimal size)
+    IO.println (sweep.toJson opts.threshold repro)
+  return if flagged == 0 then 0 else 1
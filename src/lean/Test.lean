@@ -1,4 +1,5 @@
 import Yoga
+import Yoga.Macro
 
 open Pod (Float32)
 open Yoga
@@ -77,6 +78,19 @@ def assertUndefined (name : String) (x : Float32) : IO Bool :=
       IO.eprintln s!"{name} failed: {x} ≠ 0" *>
       pure false
 
+def assertTrue (name : String) (x : Bool) : IO Bool :=
+  if x
+    then pure true
+    else
+      IO.eprintln s!"{name} failed" *>
+      pure false
+
+def leafOf (width height : Float32) : IO (Node Unit Unit) := do
+  let node ← Node.new () ()
+  node.styleSetWidth width
+  node.styleSetHeight height
+  pure node
+
 def main : IO UInt32 := do
   let mut allOk := true
 
@@ -170,6 +184,387 @@ def main : IO UInt32 := do
   allOk := (← assertUndefined "NodeChildTest:Width2" (← child0.layoutGetWidth)) && allOk
   allOk := (← assertUndefined "NodeChildTest:Height2" (← child0.layoutGetHeight)) && allOk
 
+  /- Batch child operations -/
+  let batch ← (List.range 5).toArray.mapM fun _ => Node.new () ()
+  root.insertChildren batch 0
+  root.calculateLayout 100 undefined .ltr
+  let movedWidth ← batch[0]!.layoutGetWidth
+  root.moveChild 0 3
+  allOk := (← assertRoughlyEqual "BatchTest:MovedWidth" movedWidth (← batch[0]!.layoutGetWidth)) && allOk
+  allOk := (← assertTrue "BatchTest:MovedDirty" (← root.isDirty)) && allOk
+  root.removeChildAt 1
+  let expected := #[batch[1]!, batch[3]!, batch[0]!, batch[4]!]
+  for i in [0:expected.size] do
+    if let some child ← root.getChild? i.toUInt32 then
+      allOk := (← assertTrue "BatchTest:Order" (child == expected[i]!)) && allOk
+    else
+      IO.eprintln "BatchTest:GetChild failed"
+      allOk := false
+  root.removeChild batch[0]!
+  root.removeChildren 1 10
+  allOk := (← assertTrue "BatchTest:Count" ((← root.getChildCount) == 1)) && allOk
+  allOk := (← assertTrue "BatchTest:RemovedParent" ((← batch[4]!.getParent?).isNone)) && allOk
+  allOk := (← assertUndefined "BatchTest:RemovedWidth" (← batch[4]!.layoutGetWidth)) && allOk
+  let reinserted ← (root.insertChildren #[batch[1]!] 0).toBaseIO
+  allOk := (← assertTrue "BatchTest:Reinserted" (reinserted matches .error _)) && allOk
+  batch[1]!.insertChild batch[2]! 0
+  allOk := (← assertTrue "BatchTest:Children" ((← root.getChildren) == #[batch[1]!])) && allOk
+  allOk := (← assertTrue "BatchTest:Preorder" ((← root.toPreorderArray) == #[root, batch[1]!, batch[2]!])) && allOk
+  allOk := (← assertTrue "BatchTest:Fold" ((← root.foldPreorder 0 fun n _ => pure (n + 1)) == 3)) && allOk
+  root.removeAllChildren
+
+  /- Style classes -/
+  let styleSrc ← Node.new () ()
+  styleSrc.styleSetWidth 50
+  let cls ← StyleClass.new styleSrc
+  let member0 ← Node.new () ()
+  let member1 ← Node.new () ()
+  member0.applyClass cls
+  member1.applyClass cls
+  root.insertChild member0 0
+  root.insertChild member1 1
+  root.calculateLayout undefined undefined .ltr
+  allOk := (← assertRoughlyEqual "StyleClassTest:Width1" 50 (← member1.layoutGetWidth)) && allOk
+  styleSrc.styleSetWidth 70
+  cls.update styleSrc
+  allOk := (← assertTrue "StyleClassTest:Dirty" (← member0.isDirty)) && allOk
+  root.calculateLayout undefined undefined .ltr
+  allOk := (← assertRoughlyEqual "StyleClassTest:Width2" 70 (← member0.layoutGetWidth)) && allOk
+  allOk := (← assertRoughlyEqual "StyleClassTest:Width3" 70 (← member1.layoutGetWidth)) && allOk
+  member1.clearClass
+  allOk := (← assertTrue "StyleClassTest:MemberCount" ((← cls.getMemberCount) == 1)) && allOk
+  root.removeAllChildren
+
+  /- Whole style transfer -/
+  let styled ← Node.new () ()
+  styled.setStyle { (← styled.getStyle) with
+    width := 40, widthUnit := .point, marginLeft := 10, marginLeftUnit := .percent
+  }
+  allOk := (← assertRoughlyEqual "StyleTest:Width" 40 (← styled.styleGetWidth).value) && allOk
+  allOk := (← assertRoughlyEqual "StyleTest:MarginLeft" 10 (← styled.styleGetMargin .left).value) && allOk
+  allOk := (← assertTrue "StyleTest:MarginUnit" ((← styled.styleGetMargin .left).unit == .percent)) && allOk
+  let style ← styled.getStyle
+  allOk := (← assertRoughlyEqual "StyleTest:GetWidth" 40 style.width) && allOk
+  allOk := (← assertTrue "StyleTest:HeightUnit" (style.heightUnit == .auto)) && allOk
+
+  /- Serialization -/
+  let tree ← Node.new () ()
+  tree.styleSetFlexDirection .row
+  tree.insertChild styled 0
+  let leaf ← Node.new () ()
+  leaf.styleSetFlexGrow 1
+  tree.insertChild leaf 1
+  tree.styleSetWidth 200
+  tree.calculateLayout undefined undefined .ltr
+  let copy ← Node.deserialize (← tree.serialize) () (← tree.getConfig)
+  copy.calculateLayout undefined undefined .ltr
+  allOk := (← assertTrue "SerializeTest:ChildCount" ((← copy.getChildCount) == 2)) && allOk
+  allOk := (← assertTrue "SerializeTest:FlexDirection" ((← copy.styleGetFlexDirection) == .row)) && allOk
+  if let some copyLeaf ← copy.getChild? 1 then
+    allOk := (← assertRoughlyEqual "SerializeTest:LeafLeft" (← leaf.layoutGetLeft) (← copyLeaf.layoutGetLeft)) && allOk
+    allOk := (← assertRoughlyEqual "SerializeTest:LeafWidth" (← leaf.layoutGetWidth) (← copyLeaf.layoutGetWidth)) && allOk
+  else
+    IO.eprintln "SerializeTest:Children failed"
+    allOk := false
+  let malformed ← (Node.deserialize (ByteArray.mk #[1, 2, 3]) () (← tree.getConfig)).toBaseIO
+  allOk := (← assertTrue "SerializeTest:Malformed" (malformed matches .error _)) && allOk
+  -- A root whose direction is 9
+  let badEnum ← (Node.deserialize (ByteArray.mk #[89, 71, 76, 84, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 50, 9]) () (← tree.getConfig)).toBaseIO
+  allOk := (← assertTrue "SerializeTest:BadEnum" (badEnum matches .error _)) && allOk
+  let badCount ← (Node.deserialize (ByteArray.mk #[89, 71, 76, 84, 1, 0, 0, 0, 255, 255, 255, 255, 128, 128, 128, 128, 15, 0, 0]) () (← tree.getConfig)).toBaseIO
+  allOk := (← assertTrue "SerializeTest:BadCount" (badCount matches .error _)) && allOk
+  let copyCount := (← copy.toPreorderArray).size
+  let encodedLayout ← copy.encodeLayout
+  allOk := (← assertTrue "SerializeTest:EncodedLayout" (encodedLayout.size == 4 + 16 * copyCount && encodedLayout.get! 0 == copyCount.toUInt8)) && allOk
+
+  /- Layout snapshots -/
+  let snapshotPath : System.FilePath := "snapshot-test.bin"
+  tree.saveSnapshot snapshotPath 300 undefined .ltr
+  let loaded ← Node.loadSnapshot snapshotPath () (← tree.getConfig)
+  IO.FS.removeFile snapshotPath
+  allOk := (← assertTrue "SnapshotTest:Clean" (!(← loaded.getHasNewLayout) && !(← loaded.isDirty))) && allOk
+  allOk := (← assertRoughlyEqual "SnapshotTest:Width" (← tree.layoutGetWidth) (← loaded.layoutGetWidth)) && allOk
+  if let some loadedLeaf ← loaded.getChild? 1 then
+    allOk := (← assertTrue "SnapshotTest:LeafClean" (!(← loadedLeaf.getHasNewLayout))) && allOk
+    allOk := (← assertRoughlyEqual "SnapshotTest:LeafLeft" (← leaf.layoutGetLeft) (← loadedLeaf.layoutGetLeft)) && allOk
+    loaded.calculateLayout 300 undefined .ltr
+    allOk := (← assertTrue "SnapshotTest:RelayoutClean" (!(← loadedLeaf.getHasNewLayout))) && allOk
+    allOk := (← assertRoughlyEqual "SnapshotTest:Relayout" (← leaf.layoutGetWidth) (← loadedLeaf.layoutGetWidth)) && allOk
+  else
+    IO.eprintln "SnapshotTest:Children failed"
+    allOk := false
+  tree.removeAllChildren
+
+  /- Dirty queue -/
+  let queue ← DirtyQueue.new
+  let forest ← (List.range 3).toArray.mapM fun _ => Node.new () ()
+  for tracked in forest do
+    queue.track tracked 100 100 .ltr
+  allOk := (← assertTrue "DirtyQueueTest:Flush" ((← queue.flush) == 3)) && allOk
+  let dirtied ← IO.mkRef 0
+  forest[1]!.setDirtiedFunc fun _ => dirtied.modify (· + 1)
+  forest[1]!.styleSetWidth 10
+  forest[1]!.styleSetHeight 10
+  allOk := (← assertTrue "DirtyQueueTest:Pending" ((← dirtied.get) == 1 && (← queue.getPendingCount) == 1)) && allOk
+  allOk := (← assertTrue "DirtyQueueTest:Reflush" ((← queue.flush) == 1 && (← queue.flush) == 0)) && allOk
+  allOk := (← assertTrue "DirtyQueueTest:Clean" (!(← forest[1]!.isDirty))) && allOk
+  queue.untrack forest[1]!
+
+  /- Resize coalescing -/
+  let resized ← Node.new () ()
+  resized.styleSetFlexGrow 1
+  resized.requestLayout 100 100 .ltr
+  resized.requestLayout 200 100 .ltr
+  allOk := (← assertTrue "ResizeTest:Flush" (← resized.flushLayout)) && allOk
+  allOk := (← assertRoughlyEqual "ResizeTest:Width" 200 (← resized.layoutGetWidth)) && allOk
+  resized.requestLayout 200 100 .ltr
+  allOk := (← assertTrue "ResizeTest:SameSize" (!(← resized.flushLayout))) && allOk
+  resized.setLayoutQuantization true
+  resized.requestLayout 200.2 100 .ltr
+  allOk := (← assertTrue "ResizeTest:Quantized" (!(← resized.flushLayout))) && allOk
+  resized.calculateLayout 50 100 .ltr
+  resized.requestLayout 200 100 .ltr
+  allOk := (← assertTrue "ResizeTest:AfterDirectFlush" (← resized.flushLayout)) && allOk
+  allOk := (← assertRoughlyEqual "ResizeTest:AfterDirectLayout" 200 (← resized.layoutGetWidth)) && allOk
+
+  /- Baseline -/
+  let baselineRow ← Node.new () ()
+  baselineRow.styleSetFlexDirection .row
+  baselineRow.styleSetAlignItems .baseline
+  let tall ← leafOf 20 40
+  let short ← leafOf 20 10
+  let baselineCalls ← IO.mkRef 0
+  tall.setBaselineFraction 0.5
+  short.setBaselineFunc fun _ _ height => do
+    baselineCalls.modify (· + 1)
+    pure height
+  baselineRow.insertChildren #[tall, short] 0
+  baselineRow.calculateLayout undefined undefined .ltr
+  allOk := (← assertRoughlyEqual "BaselineTest:Top" 10 (← short.layoutGetTop)) && allOk
+  let callsAfterFirst ← baselineCalls.get
+  baselineRow.calculateLayout 300 undefined .ltr
+  allOk := (← assertTrue "BaselineTest:Cached" ((← baselineCalls.get) == callsAfterFirst)) && allOk
+  short.invalidateBaseline
+  allOk := (← assertTrue "BaselineTest:Invalidated" ((← short.isDirty) && (← baselineRow.isDirty))) && allOk
+  baselineRow.calculateLayout 300 undefined .ltr
+  allOk := (← assertTrue "BaselineTest:Recomputed" ((← baselineCalls.get) > callsAfterFirst)) && allOk
+
+  /- Layout animation -/
+  let animRoot ← Node.new () ()
+  let staying ← leafOf 10 10
+  let leaving ← leafOf 10 10
+  let arriving ← leafOf 10 10
+  animRoot.insertChildren #[leaving, staying] 0
+  animRoot.calculateLayout undefined undefined .ltr
+  let exported ← animRoot.exportLayout
+  allOk := (← assertTrue "AnimationTest:Export" (exported.size == 3 && exported.top.get! 2 == 10)) && allOk
+  let anim : LayoutAnimation Unit Unit ← LayoutAnimation.new
+  anim.captureStart animRoot
+  animRoot.removeChild leaving
+  animRoot.insertChild arriving 1
+  animRoot.calculateLayout undefined undefined .ltr
+  anim.captureEnd animRoot
+  let half ← anim.sample 0.5
+  allOk := (← assertTrue "AnimationTest:Size" (half.size == 4 && (← anim.getNodes).size == 4)) && allOk
+  -- `staying` moves from 10 to 0, `leaving` fades out and `arriving` fades in
+  allOk := (← assertTrue "AnimationTest:Half" (half.top.get! 2 == 5 && half.opacity.get! 1 == 0.5 && half.opacity.get! 3 == 0.5)) && allOk
+  let eased ← anim.sample 0.5 .easeIn
+  allOk := (← assertTrue "AnimationTest:Eased" (eased.top.get! 2 == 8.75)) && allOk
+
+  /- Pixel grid rounding of layout buffers -/
+  let unrounded : LayoutBuffer := {
+    left := ⟨#[0.3, 10.7]⟩, top := ⟨#[0, 0.2]⟩, width := ⟨#[10.4, 5]⟩
+    height := ⟨#[1.5, 1]⟩, opacity := ⟨#[1, 1]⟩
+  }
+  let rounded := unrounded.roundToPixelGrid 1
+  allOk := (← assertTrue "RoundingTest:Widths" (rounded.left.get! 0 == 0 && rounded.width.get! 0 == 11 && rounded.left.get! 1 == 11)) && allOk
+  allOk := (← assertTrue "RoundingTest:Heights" (rounded.height.get! 0 == 2 && rounded.top.get! 1 == 0)) && allOk
+  let halfPixels := unrounded.roundToPixelGrid 2
+  allOk := (← assertTrue "RoundingTest:HalfPixels" (halfPixels.left.get! 0 == 0.5 && halfPixels.width.get! 0 == 10)) && allOk
+  allOk := (← assertTrue "RoundingTest:NoGrid" ((unrounded.roundToPixelGrid 0).left.get! 0 == 0.3)) && allOk
+
+  /- Layout store -/
+  let store ← LayoutStore.new
+  allOk := (← assertTrue "LayoutStoreTest:Empty" ((← store.acquire) == 0 && (← store.getRect 0).isNone)) && allOk
+  let storeRoot ← leafOf 30 20
+  store.calculateLayout storeRoot undefined undefined .ltr
+  storeRoot.styleSetWidth 40
+  store.calculateLayout storeRoot undefined undefined .ltr
+  allOk := (← assertTrue "LayoutStoreTest:Acquire" ((← store.acquire) == 2)) && allOk
+  if let some rect ← store.getRect 0 then
+    allOk := (← assertRoughlyEqual "LayoutStoreTest:Width" 40 rect.width) && allOk
+  else
+    IO.eprintln "LayoutStoreTest:Rect failed"
+    allOk := false
+  allOk := (← assertTrue "LayoutStoreTest:Read" ((← store.read).size == 1)) && allOk
+  -- Nothing newer was published
+  allOk := (← assertTrue "LayoutStoreTest:Unchanged" ((← store.acquire) == 2)) && allOk
+
+  /- Layout scheduler -/
+  let (scheduler, offscreen) := (default : LayoutScheduler Unit Unit).add (← leafOf 10 10) 5 100 100 .ltr
+  let (scheduler, visible) := scheduler.add (← leafOf 10 10) 0 100 100 .ltr
+  -- A zero budget still lays out the most urgent root
+  let (scheduler, report) ← scheduler.runFrame 0
+  allOk := (← assertTrue "SchedulerTest:ZeroBudget" (report.laidOut == #[visible] && report.deferred == #[offscreen])) && allOk
+  let (scheduler, report) ← scheduler.runFrame 1000000000
+  allOk := (← assertTrue "SchedulerTest:Deferred" (report.laidOut == #[offscreen] && report.deferred.isEmpty)) && allOk
+  let (_, report) ← scheduler.runFrame 0
+  allOk := (← assertTrue "SchedulerTest:Idle" (report.laidOut.isEmpty)) && allOk
+
+  /- Memory accounting -/
+  let memoryRoot ← Node.new () ()
+  memoryRoot.insertChildren #[← leafOf 1 1, ← leafOf 1 1, ← leafOf 1 1] 0
+  let usage ← memoryRoot.memoryUsage
+  allOk := (← assertTrue "MemoryTest:Usage" (usage.nodes == 4 && usage.childrenBytes ≥ 3 * 8 && usage.configBytes > 0)) && allOk
+  allOk := (← assertTrue "MemoryTest:Wasted" (usage.wastedChildrenBytes < usage.childrenBytes && usage.total > usage.yogaNodeBytes)) && allOk
+  let live ← getLiveCounts
+  allOk := (← assertTrue "MemoryTest:LiveCounts" (live.nodes ≥ 4 && live.configs ≥ 1 && live.contexts ≥ live.nodes + live.configs)) && allOk
+  let slab ← SlabStats.get
+  if SlabStats.isEnabled () then
+    allOk := (← assertTrue "MemoryTest:Slab" (slab.pages ≥ 1 && slab.allocations ≥ 4)) && allOk
+  else
+    allOk := (← assertTrue "MemoryTest:NoSlab" (slab.allocations == 0)) && allOk
+
+  /- Arenas -/
+  let arenaConfig : Config Unit Unit ← Config.new ()
+  let arenaWidth ← withArena fun arena => do
+    let root ← arena.newNode () arenaConfig
+    root.styleSetFlexDirection .row
+    for i in [0:3] do
+      let child ← arena.newNode () arenaConfig
+      child.styleSetWidth 10
+      root.insertChild child i.toUInt32
+    root.calculateLayout undefined undefined .ltr
+    root.layoutGetWidth
+  allOk := (← assertRoughlyEqual "ArenaTest:Width" 30 arenaWidth) && allOk
+  let mixed ← (withArena fun arena => do (← Node.new () ()).insertChild (← arena.newNode () arenaConfig) 0).toBaseIO
+  allOk := (← assertTrue "ArenaTest:Mixed" (mixed matches .error _)) && allOk
+  let escaped ← (withArena fun arena => arena.newNode () arenaConfig).toBaseIO
+  allOk := (← assertTrue "ArenaTest:Escaped" (escaped matches .error _)) && allOk
+  let kept : IO.Ref (Option (Node Unit Unit × Node Unit Unit)) ← IO.mkRef none
+  let escapedPair ← (withArena fun arena => do
+    kept.set (some (← arena.newNode () arenaConfig, ← arena.newNode () arenaConfig))).toBaseIO
+  allOk := (← assertTrue "ArenaTest:EscapedPair" (escapedPair matches .error _)) && allOk
+  if let some (parent, child) ← kept.get then
+    child.styleSetWidth 15
+    parent.insertChild child 0
+    parent.calculateLayout undefined undefined .ltr
+    allOk := (← assertRoughlyEqual "ArenaTest:EscapedInsert" 15 (← parent.layoutGetWidth)) && allOk
+  else
+    IO.eprintln "ArenaTest:Kept failed"
+    allOk := false
+
+  /- Tree templates -/
+  let templateConfig : Config Unit Unit ← Config.new ()
+  let dynamicWidth : Float32 := 40
+  let templateNodes ← yoga!{ node { flexDirection := .row, width := 100, padding := 5 } [
+    node { width := dynamicWidth, height := 10 },
+    node { flexGrow := 1, measure := fun _ _ _ _ _ => pure { width := 0, height := 0 } } ] } () templateConfig
+  allOk := (← assertTrue "TemplateTest:Size" (templateNodes.size == 3)) && allOk
+  if let (some templateRoot, some fixed, some grown) := (templateNodes[0]?, templateNodes[1]?, templateNodes[2]?) then
+    templateRoot.calculateLayout undefined undefined .ltr
+    allOk := (← assertRoughlyEqual "TemplateTest:Fixed" 40 (← fixed.layoutGetWidth)) && allOk
+    allOk := (← assertRoughlyEqual "TemplateTest:Grown" 50 (← grown.layoutGetWidth)) && allOk
+    allOk := (← assertRoughlyEqual "TemplateTest:Left" 5 (← fixed.layoutGetLeft)) && allOk
+
+  /- Content sizes -/
+  let scroller ← Node.new () ()
+  scroller.styleSetOverflow .scroll
+  scroller.styleSetWidth 50
+  scroller.styleSetHeight 50
+  let scrolled ← Node.new () ()
+  scrolled.styleSetWidth 30
+  scrolled.styleSetHeight 80
+  scrolled.styleSetMargin .bottom 10
+  let wide ← Node.new () ()
+  wide.styleSetWidth 70
+  wide.styleSetHeight 5
+  scrolled.insertChild wide 0
+  let above ← leafOf 10 10
+  above.styleSetPositionType .absolute
+  above.styleSetPosition .top (-20)
+  scroller.insertChildren #[scrolled, above] 0
+  scroller.calculateLayout undefined undefined .ltr
+  scroller.updateContentSizes
+  let content ← scroller.layoutGetContentSize
+  allOk := (← assertRoughlyEqual "ContentSizeTest:Left" 0 content.left) && allOk
+  allOk := (← assertRoughlyEqual "ContentSizeTest:Top" (-20) content.top) && allOk
+  allOk := (← assertRoughlyEqual "ContentSizeTest:Width" 70 content.width) && allOk
+  allOk := (← assertRoughlyEqual "ContentSizeTest:Height" 110 content.height) && allOk
+  scrolled.setHasNewLayout false
+  scroller.updateContentSizes
+  allOk := (← assertRoughlyEqual "ContentSizeTest:Kept" 70 (← scroller.layoutGetContentSize).width) && allOk
+
+  /- Tree builder -/
+  let builderConfig : Config Unit Unit ← Config.new ()
+  let builder ← TreeBuilder.new () builderConfig fun key _ _ _ _ _ =>
+    pure { width := if key == 1 then 10 else 20, height := 5 }
+  builder.openNode { flexDirection := .row }
+  builder.leaf {} 1
+  builder.openNode {}
+  builder.leaf {} 2
+  builder.closeNode
+  builder.closeNode
+  let built ← builder.finish
+  built.calculateLayout undefined undefined .ltr
+  allOk := (← assertTrue "TreeBuilderTest:ChildCount" ((← built.getChildCount) == 2)) && allOk
+  allOk := (← assertRoughlyEqual "TreeBuilderTest:Width" 30 (← built.layoutGetWidth)) && allOk
+  allOk := (← assertRoughlyEqual "TreeBuilderTest:Height" 5 (← built.layoutGetHeight)) && allOk
+  let emptyBuilder ← TreeBuilder.new () builderConfig fun _ _ _ _ _ _ => pure { width := 0, height := 0 }
+  let unbalanced ← emptyBuilder.closeNode.toBaseIO
+  allOk := (← assertTrue "TreeBuilderTest:Unbalanced" (unbalanced matches .error _)) && allOk
+  let empty ← emptyBuilder.finish.toBaseIO
+  allOk := (← assertTrue "TreeBuilderTest:Empty" (empty matches .error _)) && allOk
+
+  /- Cache statistics -/
+  let cacheRoot ← Node.new () ()
+  cacheRoot.styleSetFlexDirection .row
+  let measured ← Node.new () ()
+  measured.setMeasureFunc fun _ _ _ _ _ => pure { width := 10, height := 10 }
+  cacheRoot.insertChildren #[measured, ← leafOf 10 10] 0
+  cacheRoot.calculateLayout 100 undefined .ltr
+  cacheRoot.calculateLayout 100 undefined .ltr
+  let hottest ← cacheRoot.hottestNodes 2
+  allOk := (← assertTrue "CacheStatsTest:Hottest" (hottest.size == 2)) && allOk
+  if CacheStats.isEnabled () then
+    let stats ← measured.getCacheStats
+    allOk := (← assertTrue "CacheStatsTest:MeasureCallbacks" (stats.measureCallbacks ≥ 1 && stats.maxPassMeasureCallbacks ≥ 1)) && allOk
+    allOk := (← assertTrue "CacheStatsTest:Layouts" ((← cacheRoot.getCacheStats).layouts ≥ 1)) && allOk
+    allOk := (← assertTrue "CacheStatsTest:HottestMeasured" (hottest.any (·.1 == measured))) && allOk
+    cacheRoot.resetCacheStats
+    allOk := (← assertTrue "CacheStatsTest:Reset" ((← measured.getCacheStats).measureCallbacks == 0)) && allOk
+
+  /- Tracing -/
+  if Trace.isEnabled () then
+    Trace.clear
+    Trace.setEnabled true
+    let traced ← leafOf 10 10
+    traced.calculateLayout undefined undefined .ltr
+    traced.styleSetWidth 20
+    Trace.setEnabled false
+    let json ← Trace.toJson
+    let has (event : String) := (json.splitOn event).length > 1
+    allOk := (← assertTrue "TraceTest:Begin" (has "\"name\":\"calculateLayout\",\"cat\":\"yoga\",\"ph\":\"B\"")) && allOk
+    allOk := (← assertTrue "TraceTest:End" (has "\"name\":\"calculateLayout\",\"cat\":\"yoga\",\"ph\":\"E\"")) && allOk
+    allOk := (← assertTrue "TraceTest:MarkDirty" (has "\"name\":\"markDirty\"")) && allOk
+    Trace.clear
+
+  /- Instrumentation -/
+  Stats.reset
+  root.styleSetWidth 10
+  root.calculateLayout undefined undefined .ltr
+  let stats ← Stats.get
+  if Stats.isEnabled () then
+    allOk := (← assertTrue "StatsTest:Layout" (stats.layoutCalls == 1 && stats.nodesVisited ≥ 1)) && allOk
+  let counted ← Node.new () ()
+  counted.insertChildren #[← leafOf 10 10, ← leafOf 10 10] 0
+  counted.calculateLayout undefined undefined .ltr
+  Stats.reset
+  -- Nothing changed, so only the root is visited although no `hasNewLayout` was cleared
+  counted.calculateLayout undefined undefined .ltr
+  if Stats.isEnabled () then
+    allOk := (← assertTrue "StatsTest:NewLayout" ((← Stats.get).nodesWithNewLayout == 1)) && allOk
+
   if allOk
     then
       IO.println s!"All OK"
@@ -137,11 +137,122 @@ structure Size where
   height : Float32
 deriving Inhabited
 
+structure LayoutRect where
+  left : Float32
+  top : Float32
+  width : Float32
+  height : Float32
+deriving Inhabited
+
 structure Value where
   value : Float32
   unit : Yoga.Unit
 deriving Inhabited
 
+/--
+Complete style of a node, transferred at once by `Node.getStyle` and `Node.setStyle`.
+`Value` properties are split into a number and a unit so that all fields stay unboxed.
+Defaults are the values a new node reports when `Config.getUseWebDefaults` is disabled.
+The field order is mirrored by `lean_yoga_Style` in `ffi.c`.
+-/
+structure Style where
+  direction : Direction := .inherit
+  flexDirection : FlexDirection := .column
+  justifyContent : Justify := .flexStart
+  alignContent : Align := .flexStart
+  alignItems : Align := .stretch
+  alignSelf : Align := .auto
+  positionType : PositionType := .relative
+  flexWrap : Wrap := .noWrap
+  overflow : Overflow := .visible
+  display : Display := .flex
+  flex : Float32 := undefined
+  flexGrow : Float32 := 0
+  flexShrink : Float32 := 0
+  flexBasis : Float32 := undefined
+  flexBasisUnit : Yoga.Unit := .auto
+  width : Float32 := undefined
+  widthUnit : Yoga.Unit := .auto
+  height : Float32 := undefined
+  heightUnit : Yoga.Unit := .auto
+  minWidth : Float32 := undefined
+  minWidthUnit : Yoga.Unit := .undefined
+  minHeight : Float32 := undefined
+  minHeightUnit : Yoga.Unit := .undefined
+  maxWidth : Float32 := undefined
+  maxWidthUnit : Yoga.Unit := .undefined
+  maxHeight : Float32 := undefined
+  maxHeightUnit : Yoga.Unit := .undefined
+  positionLeft : Float32 := undefined
+  positionLeftUnit : Yoga.Unit := .undefined
+  positionTop : Float32 := undefined
+  positionTopUnit : Yoga.Unit := .undefined
+  positionRight : Float32 := undefined
+  positionRightUnit : Yoga.Unit := .undefined
+  positionBottom : Float32 := undefined
+  positionBottomUnit : Yoga.Unit := .undefined
+  positionStart : Float32 := undefined
+  positionStartUnit : Yoga.Unit := .undefined
+  positionEnd : Float32 := undefined
+  positionEndUnit : Yoga.Unit := .undefined
+  positionHorizontal : Float32 := undefined
+  positionHorizontalUnit : Yoga.Unit := .undefined
+  positionVertical : Float32 := undefined
+  positionVerticalUnit : Yoga.Unit := .undefined
+  positionAll : Float32 := undefined
+  positionAllUnit : Yoga.Unit := .undefined
+  marginLeft : Float32 := undefined
+  marginLeftUnit : Yoga.Unit := .undefined
+  marginTop : Float32 := undefined
+  marginTopUnit : Yoga.Unit := .undefined
+  marginRight : Float32 := undefined
+  marginRightUnit : Yoga.Unit := .undefined
+  marginBottom : Float32 := undefined
+  marginBottomUnit : Yoga.Unit := .undefined
+  marginStart : Float32 := undefined
+  marginStartUnit : Yoga.Unit := .undefined
+  marginEnd : Float32 := undefined
+  marginEndUnit : Yoga.Unit := .undefined
+  marginHorizontal : Float32 := undefined
+  marginHorizontalUnit : Yoga.Unit := .undefined
+  marginVertical : Float32 := undefined
+  marginVerticalUnit : Yoga.Unit := .undefined
+  marginAll : Float32 := undefined
+  marginAllUnit : Yoga.Unit := .undefined
+  paddingLeft : Float32 := undefined
+  paddingLeftUnit : Yoga.Unit := .undefined
+  paddingTop : Float32 := undefined
+  paddingTopUnit : Yoga.Unit := .undefined
+  paddingRight : Float32 := undefined
+  paddingRightUnit : Yoga.Unit := .undefined
+  paddingBottom : Float32 := undefined
+  paddingBottomUnit : Yoga.Unit := .undefined
+  paddingStart : Float32 := undefined
+  paddingStartUnit : Yoga.Unit := .undefined
+  paddingEnd : Float32 := undefined
+  paddingEndUnit : Yoga.Unit := .undefined
+  paddingHorizontal : Float32 := undefined
+  paddingHorizontalUnit : Yoga.Unit := .undefined
+  paddingVertical : Float32 := undefined
+  paddingVerticalUnit : Yoga.Unit := .undefined
+  paddingAll : Float32 := undefined
+  paddingAllUnit : Yoga.Unit := .undefined
+  borderLeft : Float32 := undefined
+  borderTop : Float32 := undefined
+  borderRight : Float32 := undefined
+  borderBottom : Float32 := undefined
+  borderStart : Float32 := undefined
+  borderEnd : Float32 := undefined
+  borderHorizontal : Float32 := undefined
+  borderVertical : Float32 := undefined
+  borderAll : Float32 := undefined
+  gapColumn : Float32 := undefined
+  gapRow : Float32 := undefined
+  gapAll : Float32 := undefined
+  aspectRatio : Float32 := undefined
+
+instance : Inhabited Style := ⟨{}⟩
+
 opaque Node.Pointed (α β : Type) : NonemptyType.{0}
 
 structure Node (α β : Type) : Type where
@@ -215,13 +326,39 @@ opaque Node.reset (node : @& Node α β) : IO Unit
 @[extern "lean_yoga_Node_insertChild"]
 opaque Node.insertChild (node : @& Node α β) (child : Node α β) (index : UInt32) : IO Unit
 
-/-- Does nothing when index is out of bounds -/
+/--
+Insert `children` starting at `index`, clamped to the child count.
+Errors when any of the `children` already has a parent or when `node` has a measure function.
+-/
+@[extern "lean_yoga_Node_insertChildren"]
+opaque Node.insertChildren (node : @& Node α β) (children : @& Array (Node α β)) (index : UInt32) : IO Unit
+
+/--
+Replace the child at `index` with `child`.
+Does nothing when index is out of bounds or when `child` already has a parent.
+-/
 @[extern "lean_yoga_Node_swapChild"]
 opaque Node.swapChild (node child : @& Node α β) (index : UInt32) : BaseIO Unit
 
+/-- Does nothing when `child` is not a child of `node`. -/
 @[extern "lean_yoga_Node_removeChild"]
 opaque Node.removeChild (node child : @& Node α β) : BaseIO Unit
 
+/-- Does nothing when index is out of bounds -/
+@[extern "lean_yoga_Node_removeChildAt"]
+opaque Node.removeChildAt (node : @& Node α β) (index : UInt32) : BaseIO Unit
+
+/-- Remove the children in `[start, stop)`, clamped to the child count. -/
+@[extern "lean_yoga_Node_removeChildren"]
+opaque Node.removeChildren (node : @& Node α β) (start stop : UInt32) : BaseIO Unit
+
+/--
+Move the child at `src` so that it ends up at `dst`, clamped to the last index.
+Does nothing when `src` is out of bounds.
+-/
+@[extern "lean_yoga_Node_moveChild"]
+opaque Node.moveChild (node : @& Node α β) (src dst : UInt32) : BaseIO Unit
+
 @[extern "lean_yoga_Node_removeAllChildren"]
 opaque Node.removeAllChildren (node : @& Node α β) : BaseIO Unit
 
@@ -234,6 +371,18 @@ opaque Node.getParent? (node : @& Node α β) : BaseIO (Option $ Node α β)
 @[extern "lean_yoga_Node_getChildCount"]
 opaque Node.getChildCount (node : @& Node α β) : BaseIO UInt32
 
+@[extern "lean_yoga_Node_getChildren"]
+opaque Node.getChildren (node : @& Node α β) : BaseIO (Array (Node α β))
+
+/-- The whole subtree in preorder, starting with `node`, collected in one native traversal. -/
+@[extern "lean_yoga_Node_toPreorderArray"]
+opaque Node.toPreorderArray (node : @& Node α β) : BaseIO (Array (Node α β))
+
+/-- Fold over the subtree in preorder, see `Node.toPreorderArray`. -/
+def Node.foldPreorder {γ : Type} {m : Type → Type} [Monad m] [MonadLiftT BaseIO m]
+  (node : Node α β) (init : γ) (f : γ → Node α β → m γ) : m γ := do
+    (← node.toPreorderArray).foldlM f init
+
 /-- Errors when any of the `children` already has a parent or when `owner` has a measure function. -/
 @[extern "lean_yoga_Node_setChildren"]
 opaque Node.setChildren (owner : @& Node α β) (children : @& Array (Node α β)) : IO Unit
@@ -284,6 +433,121 @@ opaque Node.canUseCachedMeasurement
 @[extern "lean_yoga_Node_copyStyle"]
 opaque Node.copyStyle (dstNode srcNode : @& Node α β) : BaseIO Unit
 
+/-- Read the whole style in one call. -/
+@[extern "lean_yoga_Node_getStyle"]
+opaque Node.getStyle (node : @& Node α β) : BaseIO Style
+
+/--
+Write the whole style in one call.
+Only properties which differ from the current style are set, so an unchanged style doesn't dirty the node.
+-/
+@[extern "lean_yoga_Node_setStyle"]
+opaque Node.setStyle (node : @& Node α β) (style : @& Style) : BaseIO Unit
+
+opaque StyleClass.Pointed : NonemptyType.{0}
+
+/--
+A shared style record.
+Nodes it was applied to with `Node.applyClass` are its members and are restyled by `StyleClass.update`.
+-/
+def StyleClass : Type := StyleClass.Pointed.type
+
+instance : Nonempty StyleClass := StyleClass.Pointed.property
+
+/-- Create a class holding a copy of the style of `src`. -/
+@[extern "lean_yoga_StyleClass_new"]
+opaque StyleClass.new (src : @& Node α β) : BaseIO StyleClass
+
+/--
+Replace the style of the class with the style of `src` and reapply it to all members.
+Only members whose style changes are marked dirty.
+-/
+@[extern "lean_yoga_StyleClass_update"]
+opaque StyleClass.update (cls : @& StyleClass) (src : @& Node α β) : BaseIO Unit
+
+@[extern "lean_yoga_StyleClass_ofStyle"]
+opaque StyleClass.ofStyle (style : @& Style) : BaseIO StyleClass
+
+@[extern "lean_yoga_StyleClass_getStyle"]
+opaque StyleClass.getStyle (cls : @& StyleClass) : BaseIO Style
+
+/-- Like `StyleClass.update` but takes the new style directly. -/
+@[extern "lean_yoga_StyleClass_setStyle"]
+opaque StyleClass.setStyle (cls : @& StyleClass) (style : @& Style) : BaseIO Unit
+
+/-- Copy the style of the class to `dst` without making it a member. -/
+@[extern "lean_yoga_StyleClass_copyStyleTo"]
+opaque StyleClass.copyStyleTo (cls : @& StyleClass) (dst : @& Node α β) : BaseIO Unit
+
+@[extern "lean_yoga_StyleClass_getMemberCount"]
+opaque StyleClass.getMemberCount (cls : @& StyleClass) : BaseIO UInt32
+
+/-- Reference equality -/
+@[extern "lean_yoga_StyleClass_beq"]
+opaque StyleClass.beq (_ _ : @& StyleClass) : Bool
+
+instance : BEq StyleClass := ⟨StyleClass.beq⟩
+
+/--
+Copy the style of the class to the node and make it a member, leaving its previous class.
+Style setters called on the node afterwards are overwritten by the next `StyleClass.update`.
+-/
+@[extern "lean_yoga_Node_applyClass"]
+opaque Node.applyClass (node : @& Node α β) (cls : StyleClass) : BaseIO Unit
+
+/-- Leave the current class, keeping the style. Also done by `Node.reset`. -/
+@[extern "lean_yoga_Node_clearClass"]
+opaque Node.clearClass (node : @& Node α β) : BaseIO Unit
+
+@[extern "lean_yoga_Node_getClass"]
+opaque Node.getClass? (node : @& Node α β) : BaseIO (Option StyleClass)
+
+/--
+Encode the whole subtree in a compact versioned binary format, in one native traversal.
+Per node only the node type and the style properties which differ from the defaults are stored,
+plus the computed layout (left, top, width, height) if `withLayout` is set.
+Contexts, classes and callbacks are not stored.
+-/
+@[extern "lean_yoga_Node_serialize"]
+opaque Node.serialize (node : @& Node α β) (withLayout : Bool := false) : BaseIO ByteArray
+
+/--
+Rebuild a tree written by `Node.serialize`, all nodes sharing `ctx` and `config`.
+Stored layout is skipped, call `Node.calculateLayout` on the result.
+Errors when the data is malformed or of an unsupported version.
+-/
+@[extern "lean_yoga_Node_deserialize"]
+opaque Node.deserialize (data : @& ByteArray) (ctx : α) (config : Config α β) : IO (Node α β)
+
+/--
+Computed layout of the subtree in the preorder of `Node.serialize`:
+a little-endian `u32` node count, then `f32` left, top, width and height of every node.
+-/
+@[extern "lean_yoga_Node_encodeLayout"]
+opaque Node.encodeLayout (node : @& Node α β) : BaseIO ByteArray
+
+/--
+Lay out the tree for the owner size and direction and save it together with the layout to a file.
+Meant for trees which are static for a given window size, see `Node.loadSnapshot`.
+-/
+@[extern "lean_yoga_Node_saveSnapshot"]
+opaque Node.saveSnapshot
+  (node : @& Node α β) (path : @& System.FilePath)
+  (ownerWidth ownerHeight : Float32) (ownerDirection : Direction) :
+    IO Unit
+
+/--
+Map a file written by `Node.saveSnapshot` into memory and rebuild the laid out tree from it,
+all nodes sharing `ctx` and `config`.
+The stored left, top, width and height are written back without laying anything out,
+other layout values like margins, paddings and `layoutGetHadOverflow` read as zero.
+All nodes are clean with `hasNewLayout` cleared, and `Node.calculateLayout` with the saved owner size
+only visits the root until something changes.
+Measure and baseline functions aren't stored, set them before changing a loaded tree.
+-/
+@[extern "lean_yoga_Node_loadSnapshot"]
+opaque Node.loadSnapshot (path : @& System.FilePath) (ctx : α) (config : Config α β) : IO (Node α β)
+
 @[extern "lean_yoga_Node_getContext"]
 opaque Node.getContext (node : @& Node α β) : BaseIO α :=
   pure $ Classical.choice node.h₁
@@ -316,15 +580,105 @@ opaque Node.resetMeasureFunc (node : @& Node α β) : BaseIO Unit
 @[extern "lean_yoga_Node_hasBaselineFunc"]
 opaque Node.hasBaselineFunc (node : @& Node α β) : BaseIO Bool
 
--- @[extern "lean_yoga_Node_setBaselineFunc"]
--- opaque Node.setBaselineFunc (node : @& Node α β) (baselineFunc : BaselineFunc α β) : BaseIO Unit
+/--
+The baseline is cached for the last width and height it was computed for,
+call `Node.invalidateBaseline` when it changes otherwise.
+-/
+@[extern "lean_yoga_Node_setBaselineFunc"]
+opaque Node.setBaselineFunc (node : @& Node α β) (baselineFunc : BaselineFunc α β) : BaseIO Unit
+
+/--
+Forget the cached baseline and mark the node and its ancestors dirty, so the next layout asks for it again.
+Unlike `Node.markDirty` this works on nodes without a measure function.
+-/
+@[extern "lean_yoga_Node_invalidateBaseline"]
+opaque Node.invalidateBaseline (node : @& Node α β) : BaseIO Unit
+
+/--
+Use a baseline at a fixed fraction of the node's height (e.g. the font's ascent over its line height),
+computed natively without calling into Lean.
+-/
+@[extern "lean_yoga_Node_setBaselineFraction"]
+opaque Node.setBaselineFraction (node : @& Node α β) (fraction : Float32) : BaseIO Unit
+
+@[extern "lean_yoga_Node_resetBaselineFunc"]
+opaque Node.resetBaselineFunc (node : @& Node α β) : BaseIO Unit
 
 -- @[extern "lean_yoga_Node_getDirtiedFunc"]
 -- opaque Node.getDirtiedFunc (node : @& Node α β) : BaseIO (DirtiedFunc α β) :=
 --   pure λ _ ↦ pure ()
 
--- @[extern "lean_yoga_Node_setDirtiedFunc"]
--- opaque Node.setDirtiedFunc (node : @& Node α β) (dirtiedFunc : DirtiedFunc α β) : BaseIO Unit
+/-- Called when the node goes from clean to dirty. -/
+@[extern "lean_yoga_Node_setDirtiedFunc"]
+opaque Node.setDirtiedFunc (node : @& Node α β) (dirtiedFunc : DirtiedFunc α β) : BaseIO Unit
+
+@[extern "lean_yoga_Node_resetDirtiedFunc"]
+opaque Node.resetDirtiedFunc (node : @& Node α β) : BaseIO Unit
+
+opaque DirtyQueue.Pointed : NonemptyType.{0}
+
+/--
+Collects tracked roots when they become dirty, natively and without calling into Lean,
+so that a frame lays out only the roots which changed.
+Several mutations of a root before the next `DirtyQueue.flush` queue it once.
+Queued roots are kept alive until flushed or untracked.
+-/
+def DirtyQueue : Type := DirtyQueue.Pointed.type
+
+instance : Nonempty DirtyQueue := DirtyQueue.Pointed.property
+
+@[extern "lean_yoga_DirtyQueue_new"]
+opaque DirtyQueue.new : BaseIO DirtyQueue
+
+/--
+Queue `root` whenever it becomes dirty, to be laid out with the given owner size and direction.
+Tracking again updates the layout parameters.
+A root which is dirty or was never laid out is queued immediately.
+Errors when `root` is waiting in another queue.
+-/
+@[extern "lean_yoga_DirtyQueue_track"]
+opaque DirtyQueue.track
+  (queue : @& DirtyQueue) (root : @& Node α β)
+  (ownerWidth ownerHeight : Float32) (ownerDirection : Direction) :
+    IO Unit
+
+/-- Stop tracking `root`, removing it from the queue. -/
+@[extern "lean_yoga_DirtyQueue_untrack"]
+opaque DirtyQueue.untrack (queue : @& DirtyQueue) (root : @& Node α β) : BaseIO Unit
+
+@[extern "lean_yoga_DirtyQueue_getPendingCount"]
+opaque DirtyQueue.getPendingCount (queue : @& DirtyQueue) : BaseIO UInt32
+
+/--
+Lay out the queued roots and empty the queue, returning how many were laid out.
+Does nothing when no tracked root changed since the last flush.
+-/
+@[extern "lean_yoga_DirtyQueue_flush"]
+opaque DirtyQueue.flush (queue : @& DirtyQueue) : BaseIO UInt32
+
+/--
+Record the owner size and direction for the next `Node.flushLayout`, replacing earlier requests.
+Meant to be called on every resize event, a tracked root is queued in its `DirtyQueue`.
+-/
+@[extern "lean_yoga_Node_requestLayout"]
+opaque Node.requestLayout
+  (root : @& Node α β) (ownerWidth ownerHeight : Float32) (ownerDirection : Direction) :
+    BaseIO Unit
+
+/--
+Lay out the root with the most recently requested parameters,
+unless the root is clean and they equal those of its last layout.
+Returns whether a layout pass ran.
+-/
+@[extern "lean_yoga_Node_flushLayout"]
+opaque Node.flushLayout (root : @& Node α β) : BaseIO Bool
+
+/--
+Round requested owner sizes to the pixel grid of the node's config (see `Config.setPointScaleFactor`),
+so that subpixel resizes don't trigger layout.
+-/
+@[extern "lean_yoga_Node_setLayoutQuantization"]
+opaque Node.setLayoutQuantization (root : @& Node α β) (quantize : Bool) : BaseIO Unit
 
 @[extern "lean_yoga_Node_getHasNewLayout"]
 opaque Node.getHasNewLayout (node : @& Node α β) : BaseIO Bool
@@ -597,6 +951,23 @@ opaque Node.layoutGetBorder (node : @& Node α β) (edge : Edge) : IO Float32
 @[extern "lean_yoga_Node_layoutGetPadding"]
 opaque Node.layoutGetPadding (node : @& Node α β) (edge : Edge) : IO Float32
 
+/--
+Compute content sizes of the nodes in the tree after layout,
+visiting only nodes with `hasNewLayout` set, so call it before clearing that flag.
+-/
+@[extern "lean_yoga_Node_updateContentSizes"]
+opaque Node.updateContentSizes (node : @& Node α β) : BaseIO Unit
+
+/--
+Bounds of the union of the margin boxes of the node's descendants, relative to its top left corner,
+as of the last `Node.updateContentSizes`. Empty at the corner for nodes without children.
+`left` and `top` are negative when content sticks out before the node, e.g. through negative margins.
+Descendants of nodes with overflow `hidden` or `scroll` only count towards the content of those nodes,
+so for a scroll container this is the extent of the scrolled content.
+-/
+@[extern "lean_yoga_Node_layoutGetContentSize"]
+opaque Node.layoutGetContentSize (node : @& Node α β) : BaseIO LayoutRect
+
 -- @[extern "lean_yoga_Config_setLogger"]
 -- opaque Config.setLogger (config : @& Config) (logger : Logger) : IO Unit
 
@@ -666,3 +1037,433 @@ opaque Config.getErrata (config : @& Config α β) : BaseIO Errata
 
 @[extern "lean_yoga_roundValueToPixelGrid"]
 opaque roundValueToPixelGrid (value pointScaleFactor : Float) (forceCeil forceFloor : Bool) : Float32
+
+/--
+Absolute layout of the nodes of a subtree in preorder, one array per property.
+Positions are relative to the owner of the subtree's root.
+-/
+structure LayoutBuffer where
+  left : FloatArray
+  top : FloatArray
+  width : FloatArray
+  height : FloatArray
+  /-- `1` for exported layouts, between `0` and `1` for nodes appearing or disappearing in an animation. -/
+  opacity : FloatArray
+deriving Inhabited
+
+def LayoutBuffer.size (buffer : LayoutBuffer) : Nat := buffer.left.size
+
+/-- Copy the computed layout of the subtree into a `LayoutBuffer` in preorder. -/
+@[extern "lean_yoga_Node_exportLayout"]
+opaque Node.exportLayout (root : @& Node α β) : BaseIO LayoutBuffer
+
+/--
+Round to the pixel grid of `pointScaleFactor` like Yoga does during layout,
+snapping absolute edges and deriving sizes from them. Does nothing when the factor is `0`.
+Updates the arrays in place when they aren't shared.
+-/
+@[extern "lean_yoga_LayoutBuffer_roundToPixelGrid"]
+opaque LayoutBuffer.roundToPixelGrid (buffer : LayoutBuffer) (pointScaleFactor : Float) : LayoutBuffer
+
+opaque LayoutStore.Pointed : NonemptyType.{0}
+
+/--
+Published layouts of a root, readable from another thread without locking and without touching nodes.
+One thread writes with `LayoutStore.calculateLayout` or `LayoutStore.publish`,
+one thread reads after `LayoutStore.acquire`; neither waits for the other.
+Rectangles are those of `Node.exportLayout`, in preorder.
+-/
+def LayoutStore : Type := LayoutStore.Pointed.type
+
+instance : Nonempty LayoutStore := LayoutStore.Pointed.property
+
+@[extern "lean_yoga_LayoutStore_new"]
+opaque LayoutStore.new : BaseIO LayoutStore
+
+/-- Writer: copy the current layout of `root` into the store and publish it. -/
+@[extern "lean_yoga_LayoutStore_publish"]
+opaque LayoutStore.publish (store : @& LayoutStore) (root : @& Node α β) : BaseIO Unit
+
+/-- Writer: `Node.calculateLayout` followed by `LayoutStore.publish`. -/
+@[extern "lean_yoga_LayoutStore_calculateLayout"]
+opaque LayoutStore.calculateLayout
+  (store : @& LayoutStore) (root : @& Node α β)
+  (ownerWidth ownerHeight : Float32) (ownerDirection : Direction) :
+    BaseIO Unit
+
+/--
+Reader: switch to the most recently published layout, if a newer one exists.
+Returns its generation, counting publications from `1`, or `0` when nothing was published yet.
+The reader's layout stays unchanged until the next `acquire`.
+-/
+@[extern "lean_yoga_LayoutStore_acquire"]
+opaque LayoutStore.acquire (store : @& LayoutStore) : BaseIO UInt64
+
+/-- Reader: copy of the acquired layout. -/
+@[extern "lean_yoga_LayoutStore_read"]
+opaque LayoutStore.read (store : @& LayoutStore) : BaseIO LayoutBuffer
+
+/-- Reader: rectangle of the acquired layout at a preorder index. -/
+@[extern "lean_yoga_LayoutStore_getRect"]
+opaque LayoutStore.getRect (store : @& LayoutStore) (index : UInt32) : BaseIO (Option LayoutRect)
+
+inductive Easing where
+| linear | easeIn | easeOut | easeInOut
+deriving Inhabited, DecidableEq
+
+opaque LayoutAnimation.Pointed (α β : Type) : NonemptyType.{0}
+
+/--
+Interpolates between two layouts of a subtree, all nodes at once.
+Nodes are matched between the captures by identity; slots of the start capture come first,
+in preorder, followed by nodes which only appear in the end capture.
+Disappearing nodes keep their start rectangle and fade out, appearing ones keep their end rectangle and fade in.
+-/
+def LayoutAnimation (α β : Type) : Type := (LayoutAnimation.Pointed α β).type
+
+instance : Nonempty (LayoutAnimation α β) := (LayoutAnimation.Pointed α β).property
+
+@[extern "lean_yoga_LayoutAnimation_new"]
+opaque LayoutAnimation.new : BaseIO (LayoutAnimation α β)
+
+/-- Capture the current layout of the subtree as the start of the animation, discarding previous captures. -/
+@[extern "lean_yoga_LayoutAnimation_captureStart"]
+opaque LayoutAnimation.captureStart (anim : @& LayoutAnimation α β) (root : @& Node α β) : BaseIO Unit
+
+/-- Capture the current layout of the subtree as the end of the animation, replacing a previous end capture. -/
+@[extern "lean_yoga_LayoutAnimation_captureEnd"]
+opaque LayoutAnimation.captureEnd (anim : @& LayoutAnimation α β) (root : @& Node α β) : BaseIO Unit
+
+/-- Interpolated layout at time `t` (clamped to `[0, 1]`), empty until both ends were captured. -/
+@[extern "lean_yoga_LayoutAnimation_sample"]
+opaque LayoutAnimation.sample
+  (anim : @& LayoutAnimation α β) (t : Float32) (easing : Easing := .linear) : BaseIO LayoutBuffer
+
+/-- Nodes of the animation's slots, in the order of sampled buffers. -/
+@[extern "lean_yoga_LayoutAnimation_getNodes"]
+opaque LayoutAnimation.getNodes (anim : @& LayoutAnimation α β) : BaseIO (Array (Node α β))
+
+/--
+Number of native allocations made by the bindings so far (node contexts and children arrays).
+Allocations inside Yoga itself are not counted.
+-/
+@[extern "lean_yoga_getAllocationCount"]
+opaque getAllocationCount : BaseIO UInt64
+
+/-- Objects of the bindings alive in the process. -/
+structure LiveCounts where
+  nodes : UInt64
+  configs : UInt64
+  /-- Native contexts of nodes, configs and style classes, and other small native objects. -/
+  contexts : UInt64
+  /-- Allocated capacity of children arrays. -/
+  childrenBytes : UInt64
+deriving Inhabited, Repr
+
+/-- See also `Config.getInstanceCount`, which counts Yoga's configs. -/
+@[extern "lean_yoga_getLiveCounts"]
+opaque getLiveCounts : BaseIO LiveCounts
+
+/-- Statistics of the `slab` allocator, summed over threads. -/
+structure SlabStats where
+  threads : UInt64
+  pages : UInt64
+  reservedBytes : UInt64
+  allocations : UInt64
+  frees : UInt64
+  /-- Allocations too large for the size classes, made with `malloc`. -/
+  fallbackAllocations : UInt64
+deriving Inhabited, Repr
+
+/-- Whether the bindings were built with `alloc=slab`, otherwise statistics are zero. -/
+@[extern "lean_yoga_SlabStats_isEnabled"]
+opaque SlabStats.isEnabled : Unit → Bool
+
+@[extern "lean_yoga_SlabStats_get"]
+opaque SlabStats.get : BaseIO SlabStats
+
+/-- Native memory of a subtree in bytes, by category. -/
+structure MemoryUsage where
+  nodes : UInt64
+  /-- Yoga's own node structures. -/
+  yogaNodeBytes : UInt64
+  /-- Contexts of the bindings, including layout request state of roots. -/
+  contextBytes : UInt64
+  /-- Allocated children arrays. -/
+  childrenBytes : UInt64
+  /-- Unused capacity of children arrays, included in `childrenBytes`. -/
+  wastedChildrenBytes : UInt64
+  /-- Distinct configs of the subtree's nodes, with their contexts. -/
+  configBytes : UInt64
+  /-- Closure objects of measure, baseline and dirtied callbacks, without what they capture. -/
+  callbackBytes : UInt64
+deriving Inhabited, Repr
+
+def MemoryUsage.total (usage : MemoryUsage) : UInt64 :=
+  usage.yogaNodeBytes + usage.contextBytes + usage.childrenBytes + usage.configBytes + usage.callbackBytes
+
+@[extern "lean_yoga_Node_memoryUsage"]
+opaque Node.memoryUsage (root : @& Node α β) : BaseIO MemoryUsage
+
+opaque Arena.Pointed : NonemptyType.{0}
+
+/--
+Storage of transient nodes, their contexts and children arrays, released all at once by `withArena`.
+Nodes of an arena can only be children of nodes of the same arena.
+-/
+def Arena : Type := Arena.Pointed.type
+
+instance : Nonempty Arena := Arena.Pointed.property
+
+@[extern "lean_yoga_Arena_new"]
+opaque Arena.new : BaseIO Arena
+
+/-- Errors when the arena was already released. -/
+@[extern "lean_yoga_Arena_newNode"]
+opaque Arena.newNode (arena : @& Arena) (ctx : α) (config : Config α β) : IO (Node α β)
+
+/--
+Free all nodes of the arena, errors (leaking the arena) when some are referenced
+other than by their parents, e.g. from the result of `withArena`.
+-/
+@[extern "lean_yoga_Arena_release"]
+opaque Arena.release (arena : @& Arena) : IO Unit
+
+/--
+Build, lay out and read a throwaway tree without per-node allocation and finalization costs.
+No node of the arena may outlive `f`, its memory is released when `f` returns.
+Reference counts of nodes shared with another thread (e.g. captured by a `Task`) can't be checked,
+so such nodes count as escaped and the arena is leaked.
+-/
+def withArena {γ : Type} (f : Arena → IO γ) : IO γ := do
+  let arena ← Arena.new
+  tryFinally (f arena) arena.release
+
+/-- Measure function shared by the leaves of a `TreeBuilder`, given the key of the measured leaf first. -/
+def KeyedMeasureFunc (α β : Type) : Type := UInt64 → MeasureFunc α β
+
+opaque TreeBuilder.Pointed (α β : Type) : NonemptyType.{0}
+
+/--
+Builds a tree from a stream of events, e.g. while parsing a document.
+Nodes are created and attached natively as they arrive, so besides the nodes
+the builder only keeps the path of open nodes.
+-/
+def TreeBuilder (α β : Type) : Type := (TreeBuilder.Pointed α β).type
+
+instance : Nonempty (TreeBuilder α β) := (TreeBuilder.Pointed α β).property
+
+/-- All nodes share `ctx` and `config`, leaves are measured by `measure`. -/
+@[extern "lean_yoga_TreeBuilder_new"]
+opaque TreeBuilder.new (ctx : α) (config : Config α β) (measure : KeyedMeasureFunc α β) : BaseIO (TreeBuilder α β)
+
+/-- Append a node to the innermost open node, or start the root, and open it. -/
+@[extern "lean_yoga_TreeBuilder_openNode"]
+opaque TreeBuilder.openNode (builder : @& TreeBuilder α β) (style : @& Style) : IO Unit
+
+/-- Append a node measured by the builder's measure function with `measureKey`. -/
+@[extern "lean_yoga_TreeBuilder_leaf"]
+opaque TreeBuilder.leaf (builder : @& TreeBuilder α β) (style : @& Style) (measureKey : UInt64) : IO Unit
+
+@[extern "lean_yoga_TreeBuilder_closeNode"]
+opaque TreeBuilder.closeNode (builder : @& TreeBuilder α β) : IO Unit
+
+/-- The root, once every opened node was closed. The builder can't be used afterwards. -/
+@[extern "lean_yoga_TreeBuilder_finish"]
+opaque TreeBuilder.finish (builder : @& TreeBuilder α β) : IO (Node α β)
+
+/--
+Counters since the last `Stats.reset`.
+All but `allocations` are collected only when built with the `instrument` option and are zero otherwise.
+-/
+structure Stats where
+  layoutCalls : UInt64
+  layoutNanos : UInt64
+  /-- Calls of measure functions set with `Node.setMeasureFunc` -/
+  measureCalls : UInt64
+  measureNanos : UInt64
+  /-- Nodes reached through nodes laid out by each layout pass -/
+  nodesVisited : UInt64
+  /--
+  Nodes laid out by each layout pass, i.e. whose `hasNewLayout` it set.
+  Counted by the pass which visited them, so nodes whose flag was never cleared aren't counted again,
+  but nodes served from Yoga's layout cache are.
+  -/
+  nodesWithNewLayout : UInt64
+  /-- See `getAllocationCount` -/
+  allocations : UInt64
+deriving Inhabited, Repr
+
+/-- Whether the bindings were built with the `instrument` option. -/
+@[extern "lean_yoga_Stats_isEnabled"]
+opaque Stats.isEnabled : Unit → Bool
+
+@[extern "lean_yoga_Stats_get"]
+opaque Stats.get : BaseIO Stats
+
+@[extern "lean_yoga_Stats_reset"]
+opaque Stats.reset : BaseIO Unit
+
+/-- Whether the bindings were built with the `trace` option. -/
+@[extern "lean_yoga_Trace_isEnabled"]
+opaque Trace.isEnabled : Unit → Bool
+
+/--
+Start or stop recording trace events: layout passes, measure callbacks (with the node and constraints),
+baseline callbacks and nodes dirtied by style setters, `Node.markDirty` and `Node.invalidateBaseline`.
+Events go to a per-thread ring buffer keeping the most recent ones.
+Does nothing unless built with the `trace` option.
+-/
+@[extern "lean_yoga_Trace_setEnabled"]
+opaque Trace.setEnabled (enabled : Bool) : BaseIO Unit
+
+/-- Discard the recorded events. -/
+@[extern "lean_yoga_Trace_clear"]
+opaque Trace.clear : BaseIO Unit
+
+/--
+The recorded events in the Chrome trace event JSON format, viewable in `chrome://tracing` or Perfetto.
+Can be called while other threads record, events overwritten during the export are left out.
+-/
+@[extern "lean_yoga_Trace_toJson"]
+opaque Trace.toJson : BaseIO String
+
+def Trace.dump (path : System.FilePath) : IO Unit := do
+  IO.FS.writeFile path (← Trace.toJson)
+
+/--
+Per-node counts of Yoga's layout events since the node was created or reset.
+Collected only when built with the `events` option and zero otherwise.
+-/
+structure CacheStats where
+  /-- Layouts computed from scratch -/
+  layouts : UInt64
+  /-- Measurements computed from scratch -/
+  measures : UInt64
+  cachedLayouts : UInt64
+  cachedMeasures : UInt64
+  measureCallbacks : UInt64
+  /-- Most measure callbacks of the node during a single layout pass -/
+  maxPassMeasureCallbacks : UInt64
+deriving Inhabited, Repr
+
+/-- Fraction of layouts and measurements served from Yoga's caches, zero if there were none. -/
+def CacheStats.hitRate (s : CacheStats) : Float :=
+  let hits := s.cachedLayouts + s.cachedMeasures
+  let total := hits + s.layouts + s.measures
+  if total == 0 then 0 else hits.toNat.toFloat / total.toNat.toFloat
+
+/-- Whether the bindings were built with the `events` option. -/
+@[extern "lean_yoga_CacheStats_isEnabled"]
+opaque CacheStats.isEnabled : Unit → Bool
+
+@[extern "lean_yoga_Node_getCacheStats"]
+opaque Node.getCacheStats (node : @& Node α β) : BaseIO CacheStats
+
+/-- Reset the cache statistics of the whole subtree. -/
+@[extern "lean_yoga_Node_resetCacheStats"]
+opaque Node.resetCacheStats (node : @& Node α β) : BaseIO Unit
+
+/--
+The `n` nodes of the subtree which were laid out or measured from scratch the most,
+the likeliest places where Yoga's caches are defeated.
+-/
+def Node.hottestNodes (root : Node α β) (n : Nat) : BaseIO (Array (Node α β × CacheStats)) := do
+  let nodes ← root.toPreorderArray
+  let stats ← nodes.mapM Node.getCacheStats
+  let cost (s : CacheStats) := s.layouts + s.measures + s.measureCallbacks
+  let sorted := (nodes.zip stats).qsort fun a b => cost a.2 > cost b.2
+  pure $ sorted.extract 0 n
+
+structure LayoutScheduler.Entry (α β : Type) where
+  key : Nat
+  root : Node α β
+  /-- Lower values are laid out first, e.g. `0` for visible roots. -/
+  priority : Nat
+  ownerWidth : Float32
+  ownerHeight : Float32
+  ownerDirection : Direction
+  /-- Consecutive frames the root was deferred, each one raising its priority by one. -/
+  waited : Nat := 0
+  /-- Duration of the root's previous layout, used to predict whether it fits the budget. -/
+  lastNanos : Nat := 0
+  laidOut : Bool := false
+
+/--
+Independent roots laid out a frame at a time within a time budget, most urgent first.
+A root is laid out when it is dirty or was never laid out.
+-/
+structure LayoutScheduler (α β : Type) where
+  entries : Array (LayoutScheduler.Entry α β) := #[]
+  nextKey : Nat := 0
+
+instance : Inhabited (LayoutScheduler α β) := ⟨{}⟩
+
+structure LayoutScheduler.FrameReport where
+  /-- Keys of the roots laid out, in order. -/
+  laidOut : Array Nat
+  /-- Keys of dirty roots which didn't fit the budget. -/
+  deferred : Array Nat
+  elapsedNanos : Nat
+deriving Inhabited
+
+/-- Add a root, returning the key identifying it in the scheduler. -/
+def LayoutScheduler.add
+  (s : LayoutScheduler α β) (root : Node α β) (priority : Nat)
+  (ownerWidth ownerHeight : Float32) (ownerDirection : Direction) :
+    LayoutScheduler α β × Nat :=
+  let entry := {
+    key := s.nextKey, root := root, priority := priority
+    ownerWidth := ownerWidth, ownerHeight := ownerHeight, ownerDirection := ownerDirection
+  }
+  ({ entries := s.entries.push entry, nextKey := s.nextKey + 1 }, s.nextKey)
+
+def LayoutScheduler.remove (s : LayoutScheduler α β) (key : Nat) : LayoutScheduler α β :=
+  { s with entries := s.entries.filter (·.key != key) }
+
+def LayoutScheduler.setPriority (s : LayoutScheduler α β) (key priority : Nat) : LayoutScheduler α β :=
+  { s with entries := s.entries.map fun e => if e.key == key then { e with priority := priority } else e }
+
+/-- Change the owner size of a root, laying it out again on a following frame. -/
+def LayoutScheduler.setOwnerSize
+  (s : LayoutScheduler α β) (key : Nat) (ownerWidth ownerHeight : Float32) : LayoutScheduler α β :=
+  { s with
+    entries := s.entries.map fun e =>
+      if e.key == key then { e with ownerWidth := ownerWidth, ownerHeight := ownerHeight, laidOut := false } else e }
+
+/--
+Lay out dirty roots in order of priority, aged by how long they waited,
+while their previous durations fit in what is left of `budgetNanos`.
+At least one dirty root is laid out per frame, so that every root eventually is.
+-/
+def LayoutScheduler.runFrame
+  (s : LayoutScheduler α β) (budgetNanos : Nat) : BaseIO (LayoutScheduler α β × LayoutScheduler.FrameReport) := do
+  let start ← IO.monoNanosNow
+  let mut pending : Array Nat := #[]
+  for i in [0:s.entries.size] do
+    let e := s.entries[i]!
+    if !e.laidOut || (← e.root.isDirty) then
+      pending := pending.push i
+  let urgency (e : LayoutScheduler.Entry α β) := e.priority - e.waited
+  let ordered := pending.qsort fun i j =>
+    let a := s.entries[i]!
+    let b := s.entries[j]!
+    urgency a < urgency b || (urgency a == urgency b && a.key < b.key)
+  let mut entries := s.entries
+  let mut laidOut : Array Nat := #[]
+  let mut deferred : Array Nat := #[]
+  let mut elapsed := 0
+  for i in ordered do
+    let e := entries[i]!
+    if laidOut.isEmpty || elapsed + e.lastNanos ≤ budgetNanos then
+      let before ← IO.monoNanosNow
+      e.root.calculateLayout e.ownerWidth e.ownerHeight e.ownerDirection
+      let after ← IO.monoNanosNow
+      entries := entries.set! i { e with waited := 0, lastNanos := after - before, laidOut := true }
+      laidOut := laidOut.push e.key
+      elapsed := after - start
+    else
+      entries := entries.set! i { e with waited := e.waited + 1 }
+      deferred := deferred.push e.key
+  let stop ← IO.monoNanosNow
+  pure ({ s with entries := entries }, { laidOut := laidOut, deferred := deferred, elapsedNanos := stop - start })
@@ -0,0 +1,272 @@
+import Yoga
+
+open Lean
+
+namespace Yoga
+
+variable {α β : Type}
+
+/-- Build a tree encoded like `Node.serialize`, returning its nodes in preorder. -/
+@[extern "lean_yoga_Template_instantiate"]
+opaque Template.instantiate (bytes : @& ByteArray) (ctx : α) (config : Config α β) : IO (Array (Node α β))
+
+/--
+Instantiate a template, then run the actions of its dynamic properties,
+each on the node at the given preorder index.
+-/
+def Template.instantiateWith
+  (bytes : ByteArray) (actions : Array (Nat × (Node α β → IO Unit))) (ctx : α) (config : Config α β) :
+    IO (Array (Node α β)) := do
+  let nodes ← Template.instantiate bytes ctx config
+  for (index, action) in actions do
+    if let some node := nodes[index]? then
+      action node
+  pure nodes
+
+namespace Template
+
+private def roundEven (x : Float) : Float :=
+  let r := x.round
+  if (r - x).abs == 0.5 && (r / 2).floor * 2 != r then r - 1 else r
+
+/-- IEEE 754 binary32 encoding of `x`, rounded to nearest even like a runtime conversion. -/
+def float32Bits (x : Float) : UInt32 :=
+  if x.isNaN then 0x7FC00000 else
+  let sign : UInt32 := if x < 0 || (x == 0 && 1 / x < 0) then 0x80000000 else 0
+  let a := x.abs
+  if a.isInf then sign ||| 0x7F800000 else
+  if a == 0 then sign else
+  -- `a = m * 2^e` with `m` in `[0.5, 1)`
+  let (m, e) := a.frExp
+  let biased := e + 126
+  if biased ≥ 1 then
+    let mantissa := roundEven ((m * 2 - 1) * 8388608)
+    let (biased, mantissa) := if mantissa ≥ 8388608 then (biased + 1, 0) else (biased, mantissa)
+    if biased ≥ 255
+      then sign ||| 0x7F800000
+      else sign ||| (biased.toNat.toUInt32 <<< 23) ||| mantissa.toUInt32
+  else
+    sign ||| (roundEven (a.scaleB 149)).toUInt32
+
+private def pushU32 (bytes : Array UInt8) (x : UInt32) : Array UInt8 :=
+  (((bytes.push x.toUInt8).push (x >>> 8).toUInt8).push (x >>> 16).toUInt8).push (x >>> 24).toUInt8
+
+private partial def pushVarint (bytes : Array UInt8) (x : Nat) : Array UInt8 :=
+  if x < 0x80
+    then bytes.push x.toUInt8
+    else pushVarint (bytes.push (x % 0x80 + 0x80).toUInt8) (x / 0x80)
+
+/-- How a `yoga!` property is encoded statically and set dynamically. -/
+private structure PropInfo where
+  /-- Index in the encoded style, floats first, see the tree format in `ffi.c`. -/
+  index : Nat
+  /-- Index of the unit, for properties which are values with units. -/
+  unitIndex : Option Nat := none
+  /-- Constructors of an enumeration, in order. -/
+  ctors : Array Name := #[]
+  setter : Name
+  percentSetter : Option Name := none
+  autoSetter : Option Name := none
+  /-- Leading argument of the setters, e.g. the edge. -/
+  arg : Option Name := none
+
+private def aligns : Array Name :=
+  #[`auto, `flexStart, `center, `flexEnd, `stretch, `baseline, `spaceBetween, `spaceAround]
+
+private def enumProps : List (String × Nat × Name × Array Name) := [
+  ("direction", 50, `Yoga.Node.styleSetDirection, #[`inherit, `ltr, `rtl]),
+  ("flexDirection", 51, `Yoga.Node.styleSetFlexDirection, #[`column, `columnReverse, `row, `rowReverse]),
+  ("justifyContent", 52, `Yoga.Node.styleSetJustifyContent,
+    #[`flexStart, `center, `flexEnd, `spaceBetween, `spaceAround, `spaceEvenly]),
+  ("alignContent", 53, `Yoga.Node.styleSetAlignContent, aligns),
+  ("alignItems", 54, `Yoga.Node.styleSetAlignItems, aligns),
+  ("alignSelf", 55, `Yoga.Node.styleSetAlignSelf, aligns),
+  ("positionType", 56, `Yoga.Node.styleSetPositionType, #[`static, `relative, `absolute]),
+  ("flexWrap", 57, `Yoga.Node.styleSetFlexWrap, #[`noWrap, `wrap, `wrapReverse]),
+  ("overflow", 58, `Yoga.Node.styleSetOverflow, #[`visible, `hidden, `scroll]),
+  ("display", 59, `Yoga.Node.styleSetDisplay, #[`flex, `none])
+]
+
+private def floatProps : List (String × Nat × Name × Option Name) := [
+  ("flex", 0, `Yoga.Node.styleSetFlex, none),
+  ("flexGrow", 1, `Yoga.Node.styleSetFlexGrow, none),
+  ("flexShrink", 2, `Yoga.Node.styleSetFlexShrink, none),
+  ("aspectRatio", 49, `Yoga.Node.styleSetAspectRatio, none),
+  ("columnGap", 46, `Yoga.Node.styleSetGap, some `Yoga.Gutter.column),
+  ("rowGap", 47, `Yoga.Node.styleSetGap, some `Yoga.Gutter.row),
+  ("gap", 48, `Yoga.Node.styleSetGap, some `Yoga.Gutter.all)
+]
+
+/-- Values with units: name, float index, unit index, setter stem, whether `auto` is allowed. -/
+private def valueProps : List (String × Nat × Nat × String × Bool) := [
+  ("flexBasis", 3, 60, "FlexBasis", true),
+  ("width", 4, 61, "Width", true),
+  ("height", 5, 62, "Height", true),
+  ("minWidth", 6, 63, "MinWidth", false),
+  ("minHeight", 7, 64, "MinHeight", false),
+  ("maxWidth", 8, 65, "MaxWidth", false),
+  ("maxHeight", 9, 66, "MaxHeight", false)
+]
+
+private def edges : List (String × Nat × Name) := [
+  ("", 8, `Yoga.Edge.all),
+  ("Left", 0, `Yoga.Edge.left), ("Top", 1, `Yoga.Edge.top),
+  ("Right", 2, `Yoga.Edge.right), ("Bottom", 3, `Yoga.Edge.bottom),
+  ("Start", 4, `Yoga.Edge.start), ("End", 5, `Yoga.Edge.end),
+  ("Horizontal", 6, `Yoga.Edge.horizontal), ("Vertical", 7, `Yoga.Edge.vertical)
+]
+
+/-- Edge values: name, first float index, first unit index, setter stem, whether `auto` is allowed. -/
+private def edgeProps : List (String × Nat × Option Nat × String × Bool) := [
+  ("position", 10, some 67, "Position", false),
+  ("margin", 19, some 76, "Margin", true),
+  ("padding", 28, some 85, "Padding", false),
+  ("border", 37, none, "Border", false)
+]
+
+private def setterName (stem : String) (suffix : String := "") : Name :=
+  .str `Yoga.Node s!"styleSet{stem}{suffix}"
+
+/-- Property info and whether the value is a percentage. -/
+private def propInfo? (name : String) : Option (PropInfo × Bool) := Id.run do
+  let (name, percent) :=
+    if name.endsWith "Percent" then (name.dropRight "Percent".length, true) else (name, false)
+  if !percent then
+    if let some (_, index, setter, ctors) := enumProps.find? (·.1 == name) then
+      return some ({ index := index, setter := setter, ctors := ctors }, false)
+    if let some (_, index, setter, arg) := floatProps.find? (·.1 == name) then
+      return some ({ index := index, setter := setter, arg := arg }, false)
+  if let some (_, index, unitIndex, stem, hasAuto) := valueProps.find? (·.1 == name) then
+    return some ({
+      index := index, unitIndex := some unitIndex
+      setter := setterName stem, percentSetter := setterName stem "Percent"
+      autoSetter := if hasAuto then some (setterName stem "Auto") else none
+    }, percent)
+  for (prefix_, base, unitBase, stem, hasAuto) in edgeProps do
+    for (suffix, edge, edgeName) in edges do
+      if name == prefix_ ++ suffix && (unitBase.isSome || !percent) then
+        return some ({
+          index := base + edge, unitIndex := unitBase.map (· + edge)
+          setter := setterName stem, percentSetter := unitBase.map fun _ => setterName stem "Percent"
+          autoSetter := if hasAuto then some (setterName stem "Auto") else none
+          arg := some edgeName
+        }, percent)
+  return none
+
+private partial def literalValue? : Term → Option Float
+  | `(-$x) => (literalValue? x).map (- ·)
+  | `($n:num) => some n.getNat.toFloat
+  | `($x:scientific) =>
+    let (mantissa, sign, exponent) := x.getScientific
+    some (Float.ofScientific mantissa sign exponent)
+  | _ => none
+
+private def dotIdent? (stx : Term) : Option Name :=
+  if stx.raw.isOfKind ``Lean.Parser.Term.dotIdent then some stx.raw[1].getId else none
+
+private inductive Entry where
+  | float (index : Nat) (bits : UInt32)
+  | enum (index : Nat) (value : Nat)
+
+private structure EncodeState where
+  bytes : Array UInt8 := #[]
+  nodeCount : Nat := 0
+  actions : Array Term := #[]
+
+/-- Static style entries of a property, or the action setting it at runtime. -/
+private def encodeProp (node : Nat) (prop : Syntax) :
+    MacroM (Array Entry × Option Term × Bool) := do
+  let nameStx := prop[0]
+  let name := nameStx.getId.toString
+  let value : Term := ⟨prop[2]⟩
+  let action (body : Term) : MacroM (Array Entry × Option Term × Bool) := do
+    pure (#[], some (← `(($(quote node), fun n => $body))), false)
+  match name with
+  | "measure" => return ← action (← `(Yoga.Node.setMeasureFunc n $value))
+  | "baseline" => return ← action (← `(Yoga.Node.setBaselineFunc n $value))
+  | "nodeType" =>
+    match dotIdent? value with
+    | some `text => return (#[], none, true)
+    | some `default => return (#[], none, false)
+    | _ => return ← action (← `(Yoga.Node.setNodeType n $value))
+  | _ => pure ()
+  let some (info, percent) := propInfo? name
+    | Macro.throwErrorAt nameStx s!"unknown Yoga style property '{name}'"
+  let setter := mkCIdent (if percent then info.percentSetter.getD info.setter else info.setter)
+  let dynamic : MacroM (Array Entry × Option Term × Bool) :=
+    match info.arg with
+    | some arg => do action (← `($setter n $(mkCIdent arg) $value))
+    | none => do action (← `($setter n $value))
+  if !info.ctors.isEmpty then
+    let some ctor := dotIdent? value | return ← dynamic
+    let some ctorIndex := info.ctors.indexOf? ctor
+      | Macro.throwErrorAt value s!"'{ctor}' is not a value of '{name}'"
+    return (#[.enum info.index ctorIndex.val], none, false)
+  if let some unitIndex := info.unitIndex then
+    if value.raw.isIdent && value.raw.getId == `auto && info.autoSetter.isSome && !percent then
+      return (#[.float info.index 0x7FC00000, .enum unitIndex 3], none, false)
+    let some x := literalValue? value | return ← dynamic
+    return (#[.float info.index (float32Bits x), .enum unitIndex (if percent then 2 else 1)], none, false)
+  let some x := literalValue? value | return ← dynamic
+  return (#[.float info.index (float32Bits x)], none, false)
+
+declare_syntax_cat yogaProp
+syntax ident " := " term : yogaProp
+
+declare_syntax_cat yogaNode (behavior := symbol)
+/-- A node with optional style properties and children. -/
+syntax "node" (" { " yogaProp,* " }")? (" [ " yogaNode,* " ]")? : yogaNode
+
+/-- Appends the node and its subtree in preorder, the format of `lean_yoga_Writer_tree` without layout. -/
+private partial def encodeNode (stx : Syntax) (state : EncodeState) : MacroM EncodeState := do
+  let props := if stx[1].getNumArgs == 0 then #[] else stx[1][1].getSepArgs
+  let children := if stx[2].getNumArgs == 0 then #[] else stx[2][1].getSepArgs
+  let index := state.nodeCount
+  let mut entries := #[]
+  let mut actions := state.actions
+  let mut text := false
+  for prop in props do
+    let (propEntries, action?, isText) ← encodeProp index prop
+    entries := entries ++ propEntries
+    text := text || isText
+    if let some action := action? then
+      actions := actions.push action
+  if entries.size > 255 then
+    Macro.throwErrorAt stx "too many Yoga style properties"
+  let mut bytes := pushVarint state.bytes children.size
+  bytes := bytes.push (if text then 1 else 0)
+  bytes := bytes.push entries.size.toUInt8
+  for entry in entries do
+    match entry with
+    | .float i bits => bytes := pushU32 (bytes.push i.toUInt8) bits
+    | .enum i value => bytes := (bytes.push i.toUInt8).push value.toUInt8
+  let mut state : EncodeState := { bytes := bytes, nodeCount := index + 1, actions := actions }
+  for child in children do
+    state ← encodeNode child state
+  pure state
+
+end Template
+
+/--
+A tree of nodes encoded at compile time, as a function `ctx → config → IO (Array (Node α β))`
+returning the nodes in preorder. The whole tree is built by one native call.
+```
+yoga!{ node { flexDirection := .row, padding := 8 } [
+  node { width := 100, heightPercent := 50 },
+  node { flexGrow := 1, measure := measureText } ] } ctx config
+```
+Numeric literals, enumeration constructors (`.row`) and `auto` are encoded statically,
+other values and `measure` / `baseline` callbacks are set after instantiation.
+Edge properties are named like `margin`, `marginLeft` or `paddingHorizontal`,
+a `Percent` suffix sets a percentage.
+-/
+syntax "yoga!" "{" yogaNode "}" : term
+
+macro_rules
+  | `(yoga!{ $root }) => do
+    let state ← Template.encodeNode root.raw {}
+    -- Header of the tree format: "YGLT", version 1, no flags, node count
+    let header := Template.pushU32 #[0x59, 0x47, 0x4C, 0x54, 1, 0, 0, 0] state.nodeCount.toUInt32
+    let bytes : Array Term := (header ++ state.bytes).map fun b => quote b.toNat
+    let actions := state.actions
+    `(Yoga.Template.instantiateWith (ByteArray.mk #[$bytes,*]) #[$actions,*])
@@ -1,25 +1,411 @@
+#include <errno.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <lean/lean.h>
 #include <lean_pod.h>
 #include <yoga/Yoga.h>
 
+/// Native allocations made by the bindings (contexts and children arrays), on any thread
+static _Atomic uint64_t lean_yoga_allocationCount = 0;
+
+// Live objects, decremented by finalizers which may run on any thread
+static _Atomic int64_t lean_yoga_liveNodes = 0;
+static _Atomic int64_t lean_yoga_liveConfigs = 0;
+static _Atomic int64_t lean_yoga_liveContexts = 0;
+static _Atomic int64_t lean_yoga_liveChildrenBytes = 0;
+
+static inline void lean_yoga_countLive(_Atomic int64_t* counter, int64_t delta) {
+    atomic_fetch_add_explicit(counter, delta, memory_order_relaxed);
+}
+
+static inline void lean_yoga_countAllocation(void) {
+    atomic_fetch_add_explicit(&lean_yoga_allocationCount, 1, memory_order_relaxed);
+}
+
+static inline uint64_t lean_yoga_getAllocations(void) {
+    return atomic_load_explicit(&lean_yoga_allocationCount, memory_order_relaxed);
+}
+
+#ifdef LEAN_YOGA_ALLOC_SLAB
+#define LEAN_YOGA_SLAB_CLASSES 6 // blocks of 16 to 512 bytes
+#define LEAN_YOGA_SLAB_MIN_BLOCK 16
+#define LEAN_YOGA_SLAB_PAGE_SIZE 65536
+
+typedef struct lean_yoga_SlabBlock {
+    struct lean_yoga_SlabBlock* next;
+} lean_yoga_SlabBlock;
+
+/// Free lists of one thread. Blocks freed on another thread join that thread's lists, pages are never returned.
+/// When a thread exits its cache is orphaned and adopted, free lists and all, by the next thread needing one.
+typedef struct lean_yoga_SlabCache {
+    struct lean_yoga_SlabCache* next;
+    lean_yoga_SlabBlock* free[LEAN_YOGA_SLAB_CLASSES];
+    // Written only by the owning thread
+    _Atomic uint64_t allocations;
+    _Atomic uint64_t frees;
+    _Atomic uint64_t pages;
+    _Atomic bool orphaned;
+} lean_yoga_SlabCache;
+
+static _Atomic(lean_yoga_SlabCache*) lean_yoga_slabCaches = NULL;
+static _Thread_local lean_yoga_SlabCache* lean_yoga_slabCache = NULL;
+static _Atomic uint64_t lean_yoga_slabFallbacks = 0;
+
+#ifndef _WIN32
+static pthread_key_t lean_yoga_slabCacheKey;
+static pthread_once_t lean_yoga_slabCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+/// Runs when a thread which used the slabs exits.
+static void lean_yoga_SlabCache_orphan(void* cache) {
+    lean_yoga_slabCache = NULL;
+    atomic_store_explicit(&((lean_yoga_SlabCache*)cache)->orphaned, true, memory_order_release);
+}
+
+static void lean_yoga_SlabCache_createKey(void) {
+    pthread_key_create(&lean_yoga_slabCacheKey, lean_yoga_SlabCache_orphan);
+}
+#endif
+
+/// Takes over the cache of an exited thread, if there is one.
+static lean_yoga_SlabCache* lean_yoga_SlabCache_adopt(void) {
+    for (lean_yoga_SlabCache* cache = atomic_load(&lean_yoga_slabCaches); cache != NULL; cache = cache->next) {
+        bool orphaned = true;
+        if (
+            atomic_load_explicit(&cache->orphaned, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(
+                &cache->orphaned, &orphaned, false, memory_order_acquire, memory_order_relaxed
+            )
+        ) {
+            return cache;
+        }
+    }
+    return NULL;
+}
+
+static lean_yoga_SlabCache* lean_yoga_SlabCache_get(void) {
+    if (lean_yoga_slabCache == NULL) {
+        lean_yoga_SlabCache* cache = lean_yoga_SlabCache_adopt();
+        if (cache == NULL) {
+            cache = calloc(1, sizeof(lean_yoga_SlabCache));
+            cache->next = atomic_load(&lean_yoga_slabCaches);
+            while (!atomic_compare_exchange_weak(&lean_yoga_slabCaches, &cache->next, cache));
+        }
+#ifndef _WIN32
+        pthread_once(&lean_yoga_slabCacheKeyOnce, lean_yoga_SlabCache_createKey);
+        pthread_setspecific(lean_yoga_slabCacheKey, cache);
+#endif
+        lean_yoga_slabCache = cache;
+    }
+    return lean_yoga_slabCache;
+}
+
+static inline void lean_yoga_Slab_count(_Atomic uint64_t* counter) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+static inline size_t lean_yoga_Slab_class(size_t sz) {
+    size_t sizeClass = 0;
+    for (size_t blockSize = LEAN_YOGA_SLAB_MIN_BLOCK; blockSize < sz; blockSize <<= 1) {
+        sizeClass += 1;
+    }
+    return sizeClass;
+}
+
+static void lean_yoga_Slab_refill(lean_yoga_SlabCache* cache, size_t sizeClass) {
+    size_t blockSize = (size_t)LEAN_YOGA_SLAB_MIN_BLOCK << sizeClass;
+    unsigned char* page = malloc(LEAN_YOGA_SLAB_PAGE_SIZE);
+    for (size_t offset = 0; offset + blockSize <= LEAN_YOGA_SLAB_PAGE_SIZE; offset += blockSize) {
+        lean_yoga_SlabBlock* block = (lean_yoga_SlabBlock*)(page + offset);
+        block->next = cache->free[sizeClass];
+        cache->free[sizeClass] = block;
+    }
+    lean_yoga_Slab_count(&cache->pages);
+}
+
+static inline void* lean_yoga_Slab_alloc(size_t sz) {
+    size_t sizeClass = lean_yoga_Slab_class(sz);
+    if (sizeClass >= LEAN_YOGA_SLAB_CLASSES) {
+        atomic_fetch_add_explicit(&lean_yoga_slabFallbacks, 1, memory_order_relaxed);
+        return malloc(sz);
+    }
+    lean_yoga_SlabCache* cache = lean_yoga_SlabCache_get();
+    if (cache->free[sizeClass] == NULL) {
+        lean_yoga_Slab_refill(cache, sizeClass);
+    }
+    lean_yoga_SlabBlock* block = cache->free[sizeClass];
+    cache->free[sizeClass] = block->next;
+    lean_yoga_Slab_count(&cache->allocations);
+    return block;
+}
+
+static inline void lean_yoga_Slab_free(void* p, size_t sz) {
+    size_t sizeClass = lean_yoga_Slab_class(sz);
+    if (sizeClass >= LEAN_YOGA_SLAB_CLASSES) {
+        free(p);
+        return;
+    }
+    lean_yoga_SlabCache* cache = lean_yoga_SlabCache_get();
+    lean_yoga_SlabBlock* block = p;
+    block->next = cache->free[sizeClass];
+    cache->free[sizeClass] = block;
+    lean_yoga_Slab_count(&cache->frees);
+}
+#endif
+
 /// @param sz must be divisible by `LEAN_OBJECT_SIZE_DELTA`
 static inline void* lean_yoga_alloc(size_t sz) {
-#ifdef LEAN_YOGA_ALLOC_NATIVE
+    lean_yoga_countAllocation();
+    lean_yoga_countLive(&lean_yoga_liveContexts, 1);
+#if defined(LEAN_YOGA_ALLOC_SLAB)
+    return lean_yoga_Slab_alloc(sz);
+#elif defined(LEAN_YOGA_ALLOC_NATIVE)
     return malloc(sz);
 #else
     return (void*)lean_alloc_small_object(sz);
 #endif
 }
 
-/// @param p pointer to memory allocated with `lean_raylib_alloc`
-static inline void lean_yoga_free(void* p) {
-#ifdef LEAN_YOGA_ALLOC_NATIVE
+/// @param p pointer to memory allocated with `lean_yoga_alloc`
+/// @param sz size passed to `lean_yoga_alloc`
+static inline void lean_yoga_free(void* p, size_t sz) {
+    lean_yoga_countLive(&lean_yoga_liveContexts, -1);
+#if defined(LEAN_YOGA_ALLOC_SLAB)
+    lean_yoga_Slab_free(p, sz);
+#elif defined(LEAN_YOGA_ALLOC_NATIVE)
     free(p);
 #else
     lean_free_small_object((lean_object*)p);
 #endif
 }
 
+/// Resizes a children array keeping its first `keep` elements, slab allocated in the `slab` mode.
+static inline lean_object** lean_yoga_Children_realloc(
+    lean_object** children, size_t capacity, size_t keep, size_t newCapacity
+) {
+#ifdef LEAN_YOGA_ALLOC_SLAB
+    lean_object** resized = lean_yoga_Slab_alloc(newCapacity * sizeof(lean_object*));
+    if (children != NULL) {
+        memcpy(resized, children, keep * sizeof(lean_object*));
+        lean_yoga_Slab_free(children, capacity * sizeof(lean_object*));
+    }
+    return resized;
+#else
+    return realloc(children, newCapacity * sizeof(lean_object*));
+#endif
+}
+
+static inline void lean_yoga_Children_free(lean_object** children, size_t capacity) {
+#ifdef LEAN_YOGA_ALLOC_SLAB
+    if (children != NULL) {
+        lean_yoga_Slab_free(children, capacity * sizeof(lean_object*));
+    }
+#else
+    free(children);
+#endif
+}
+
+#if defined(LEAN_YOGA_INSTRUMENT) || defined(LEAN_YOGA_TRACE)
+static inline uint64_t lean_yoga_nanos(void) {
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+#ifdef LEAN_YOGA_INSTRUMENT
+typedef struct {
+    uint64_t layoutCalls;
+    uint64_t layoutNanos;
+    uint64_t measureCalls;
+    uint64_t measureNanos;
+    uint64_t nodesVisited;
+    uint64_t nodesWithNewLayout;
+} lean_yoga_Stats;
+
+static lean_yoga_Stats lean_yoga_stats = { 0 };
+#endif
+
+typedef enum {
+    LEAN_YOGA_TRACE_LAYOUT,
+    LEAN_YOGA_TRACE_MEASURE,
+    LEAN_YOGA_TRACE_BASELINE,
+    LEAN_YOGA_TRACE_MARK_DIRTY
+} lean_yoga_TraceKind;
+
+#ifdef LEAN_YOGA_TRACE
+typedef struct {
+    uint64_t nanos;
+    const void* node;
+    float width;
+    float height;
+    uint8_t phase; // 'B', 'E' or 'i' as in the trace event format
+    uint8_t kind;
+    uint8_t widthMode;
+    uint8_t heightMode;
+} lean_yoga_TraceEvent;
+
+#define LEAN_YOGA_TRACE_CAPACITY (1u << 15)
+
+/// Single-producer ring of the events of one thread, never freed.
+typedef struct lean_yoga_TraceBuffer {
+    struct lean_yoga_TraceBuffer* next;
+    uint32_t tid;
+    // Number of events ever written; published with release after each write
+    _Atomic uint64_t head;
+    // Events before this index were discarded by `Trace.clear`
+    _Atomic uint64_t start;
+    lean_yoga_TraceEvent events[LEAN_YOGA_TRACE_CAPACITY];
+} lean_yoga_TraceBuffer;
+
+static _Atomic bool lean_yoga_traceEnabled = false;
+static _Atomic(lean_yoga_TraceBuffer*) lean_yoga_traceBuffers = NULL;
+static _Atomic uint32_t lean_yoga_traceThreadCount = 0;
+static _Thread_local lean_yoga_TraceBuffer* lean_yoga_traceBuffer = NULL;
+
+static lean_yoga_TraceBuffer* lean_yoga_TraceBuffer_get(void) {
+    if (lean_yoga_traceBuffer == NULL) {
+        lean_yoga_TraceBuffer* buffer = malloc(sizeof(lean_yoga_TraceBuffer));
+        buffer->tid = atomic_fetch_add(&lean_yoga_traceThreadCount, 1) + 1;
+        atomic_init(&buffer->head, 0);
+        atomic_init(&buffer->start, 0);
+        buffer->next = atomic_load(&lean_yoga_traceBuffers);
+        while (!atomic_compare_exchange_weak(&lean_yoga_traceBuffers, &buffer->next, buffer));
+        lean_yoga_traceBuffer = buffer;
+    }
+    return lean_yoga_traceBuffer;
+}
+
+static void lean_yoga_trace(
+    uint8_t phase, lean_yoga_TraceKind kind, const void* node,
+    float width, YGMeasureMode widthMode, float height, YGMeasureMode heightMode
+) {
+    if (!atomic_load_explicit(&lean_yoga_traceEnabled, memory_order_relaxed)) {
+        return;
+    }
+    lean_yoga_TraceBuffer* buffer = lean_yoga_TraceBuffer_get();
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    // Orders the previous `head` before overwriting the slot, for the check in `Trace.toJson`
+    atomic_thread_fence(memory_order_release);
+    buffer->events[head & (LEAN_YOGA_TRACE_CAPACITY - 1)] = (lean_yoga_TraceEvent){
+        .nanos = lean_yoga_nanos(),
+        .node = node,
+        .width = width,
+        .height = height,
+        .phase = phase,
+        .kind = kind,
+        .widthMode = widthMode,
+        .heightMode = heightMode
+    };
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+#define LEAN_YOGA_TRACE_EVENT(...) lean_yoga_trace(__VA_ARGS__)
+/// Runs a style setter, tracing when it dirtied the node (it only does so when the value changed).
+#define LEAN_YOGA_TRACE_STYLE_SET(node, set) \
+    do { \
+        bool wasDirty = YGNodeIsDirty(node); \
+        set; \
+        if (!wasDirty && YGNodeIsDirty(node)) { \
+            lean_yoga_trace('i', LEAN_YOGA_TRACE_MARK_DIRTY, node, 0, 0, 0, 0); \
+        } \
+    } while (0)
+#else
+#define LEAN_YOGA_TRACE_EVENT(...) ((void)0)
+#define LEAN_YOGA_TRACE_STYLE_SET(node, set) set
+#endif
+
+static uint64_t lean_yoga_allocationCountAtReset = 0;
+
+#ifdef LEAN_YOGA_EVENTS
+/// Per-node aggregate of Yoga's layout events, see `internal.cpp`.
+typedef struct {
+    uint64_t layouts;
+    uint64_t measures;
+    uint64_t cachedLayouts;
+    uint64_t cachedMeasures;
+    uint64_t measureCallbacks;
+    uint64_t maxPassMeasureCallbacks;
+    uint64_t lastPass;
+    uint64_t passMeasureCallbacks;
+} lean_yoga_CacheStats;
+
+/// Layout passes started on any thread
+static _Atomic uint64_t lean_yoga_layoutPass = 0;
+/// The pass running on this thread, unique across threads
+static _Thread_local uint64_t lean_yoga_currentPass = 0;
+
+void lean_yoga_events_subscribe(void);
+#endif
+
+// Defined in `internal.cpp`
+size_t lean_yoga_sizeofYGNode(void);
+size_t lean_yoga_sizeofYGConfig(void);
+YGNodeRef lean_yoga_placeYGNode(void* memory, YGConfigRef config);
+void lean_yoga_destroyYGNode(YGNodeRef node);
+void lean_yoga_markDirtyAndPropagate(YGNodeRef node);
+void lean_yoga_setChildren(
+    YGNodeRef node, const YGNodeRef* children, size_t count, const YGNodeRef* detached, size_t detachedCount
+);
+uint32_t lean_yoga_layoutGeneration(YGNodeRef node);
+void lean_yoga_restoreLayout(YGNodeRef node, float left, float top, float width, float height);
+void lean_yoga_markRestored(YGNodeRef node, YGDirection direction, YGDirection ownerDirection);
+void lean_yoga_getCachedLayout(
+    YGNodeRef node, float* availableWidth, float* availableHeight, uint8_t* widthMode, uint8_t* heightMode
+);
+void lean_yoga_setCachedLayout(
+    YGNodeRef node, float availableWidth, float availableHeight, uint8_t widthMode, uint8_t heightMode
+);
+
+#define LEAN_YOGA_ARENA_CHUNK_SIZE 65536
+#define LEAN_YOGA_ARENA_ALIGN 16
+
+typedef struct lean_yoga_ArenaChunk {
+    struct lean_yoga_ArenaChunk* next;
+    size_t used;
+    size_t capacity;
+    _Alignas(LEAN_YOGA_ARENA_ALIGN) unsigned char data[];
+} lean_yoga_ArenaChunk;
+
+/// Bump allocator of nodes, their contexts and children arrays, all released at once.
+typedef struct lean_yoga_Arena {
+    lean_yoga_ArenaChunk* chunks;
+    // Every node of the arena, each referenced once
+    lean_object** nodes;
+    size_t nodeCount;
+    size_t nodeCapacity;
+    bool released;
+} lean_yoga_Arena;
+
+static void* lean_yoga_Arena_alloc(lean_yoga_Arena* arena, size_t size) {
+    size = (size + LEAN_YOGA_ARENA_ALIGN - 1) & ~(size_t)(LEAN_YOGA_ARENA_ALIGN - 1);
+    lean_yoga_ArenaChunk* chunk = arena->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > LEAN_YOGA_ARENA_CHUNK_SIZE ? size : LEAN_YOGA_ARENA_CHUNK_SIZE;
+        chunk = malloc(sizeof(lean_yoga_ArenaChunk) + capacity);
+        chunk->next = arena->chunks;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        arena->chunks = chunk;
+        lean_yoga_countAllocation();
+    }
+    void* p = chunk->data + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
 // TODO: children as a flexible array
 typedef struct {
     lean_object* self;
@@ -29,14 +415,102 @@ typedef struct {
     lean_object** children;
     size_t childrenCapacity;
     lean_object* measureFunc;
+    // `measureFunc` takes `measureKey` first, see `lean_yoga_TreeBuilder_leaf`
+    uint64_t measureKey;
+    bool measureKeyed;
+    // Position in the children of `parent`, valid while it isn't null
+    size_t index;
+    lean_object* styleClass;
+    // Links of the intrusive list of `styleClass` members (not owned)
+    lean_object* classPrev;
+    lean_object* classNext;
+    lean_object* dirtiedFunc;
+    // Lean baseline function, or null when `baselineFraction` of the height is used
+    lean_object* baselineFunc;
+    float baselineFraction;
+    // Last baseline computed by `lean_yoga_baselineFunc`, valid if `baselineCached`
+    float baselineCacheWidth;
+    float baselineCacheHeight;
+    float baselineCacheValue;
+    bool baselineCached;
+    // Left, top, right and bottom of the union of the descendants' margin boxes,
+    // see `lean_yoga_Node_updateContentSizes`
+    float contentBounds[4];
+    // Layout parameters of a root node, allocated on first use
+    struct lean_yoga_Root* root;
+    // Arena owning the node, its context and children array, or null
+    lean_yoga_Arena* arena;
+#ifdef LEAN_YOGA_EVENTS
+    lean_yoga_CacheStats cacheStats;
+#endif
 } lean_yoga_Node_context;
 
+/// Queue of dirtied roots, each referenced once while queued.
+typedef struct {
+    lean_object** roots;
+    size_t size;
+    size_t capacity;
+} lean_yoga_DirtyQueue;
+
+typedef struct lean_yoga_Root {
+    // `DirtyQueue` notified when the root becomes dirty, or null
+    lean_object* dirtyQueue;
+    // Requested layout parameters, the most recent request wins
+    float ownerWidth;
+    float ownerHeight;
+    // Parameters of the last layout, valid if `laidOut`
+    float lastWidth;
+    float lastHeight;
+    uint8_t ownerDir;
+    uint8_t lastDir;
+    bool queued;
+    bool laidOut;
+    // Round requested sizes to the pixel grid of the config
+    bool quantize;
+} lean_yoga_Root;
+
 typedef struct {
     lean_object* value;
 } lean_yoga_Config_context;
 
+/// Context of the node which only carries the style of a `StyleClass`.
+typedef struct {
+    lean_object* first;
+    size_t memberCount;
+} lean_yoga_StyleClass_context;
+
 static lean_external_class* lean_yoga_Node_class = NULL;
+// Nodes of an arena aren't finalized individually
+static lean_external_class* lean_yoga_ArenaNode_class = NULL;
+static lean_external_class* lean_yoga_Arena_class = NULL;
 static lean_external_class* lean_yoga_Config_class = NULL;
+static lean_external_class* lean_yoga_StyleClass_class = NULL;
+static lean_external_class* lean_yoga_DirtyQueue_class = NULL;
+static lean_external_class* lean_yoga_LayoutAnimation_class = NULL;
+static lean_external_class* lean_yoga_LayoutStore_class = NULL;
+static lean_external_class* lean_yoga_TreeBuilder_class = NULL;
+
+static inline lean_yoga_Node_context* lean_yoga_Node_context_of(b_lean_obj_arg node) {
+    return YGNodeGetContext((YGNodeRef)lean_get_external_data(node));
+}
+
+static void lean_yoga_StyleClass_unlink(lean_yoga_Node_context* ctx) {
+    lean_yoga_StyleClass_context* clsCtx = YGNodeGetContext(lean_get_external_data(ctx->styleClass));
+    if (ctx->classPrev != NULL) {
+        lean_yoga_Node_context_of(ctx->classPrev)->classNext = ctx->classNext;
+    }
+    else {
+        clsCtx->first = ctx->classNext;
+    }
+    if (ctx->classNext != NULL) {
+        lean_yoga_Node_context_of(ctx->classNext)->classPrev = ctx->classPrev;
+    }
+    clsCtx->memberCount -= 1;
+    ctx->classPrev = NULL;
+    ctx->classNext = NULL;
+    lean_dec_ref(ctx->styleClass);
+    ctx->styleClass = NULL;
+}
 
 static void lean_yoga_Node_foreach(void* node, b_lean_obj_arg f) {
     lean_yoga_Node_context* ctx = YGNodeGetContext((YGNodeRef)node);
@@ -48,6 +522,90 @@ static void lean_yoga_Node_foreach(void* node, b_lean_obj_arg f) {
         lean_inc_ref(ctx->children[i]);
         lean_apply_1(f, ctx->children[i]);
     }
+    if (ctx->styleClass != NULL) {
+        lean_inc_ref(f);
+        lean_inc_ref(ctx->styleClass);
+        lean_apply_1(f, ctx->styleClass);
+    }
+    if (ctx->measureFunc != NULL) {
+        lean_inc_ref(f);
+        lean_inc_ref(ctx->measureFunc);
+        lean_apply_1(f, ctx->measureFunc);
+    }
+    if (ctx->baselineFunc != NULL) {
+        lean_inc_ref(f);
+        lean_inc_ref(ctx->baselineFunc);
+        lean_apply_1(f, ctx->baselineFunc);
+    }
+    if (ctx->dirtiedFunc != NULL) {
+        lean_inc_ref(f);
+        lean_inc_ref(ctx->dirtiedFunc);
+        lean_apply_1(f, ctx->dirtiedFunc);
+    }
+    if (ctx->root != NULL && ctx->root->dirtyQueue != NULL) {
+        lean_inc_ref(f);
+        lean_inc_ref(ctx->root->dirtyQueue);
+        lean_apply_1(f, ctx->root->dirtyQueue);
+    }
+}
+
+static void lean_yoga_DirtyQueue_foreach(void* queue, b_lean_obj_arg f) {
+    lean_yoga_DirtyQueue* q = queue;
+    for (size_t i = 0; i < q->size; ++i) {
+        lean_inc_ref(f);
+        lean_inc_ref(q->roots[i]);
+        lean_apply_1(f, q->roots[i]);
+    }
+}
+
+static void lean_yoga_DirtyQueue_finalizer(void* queue) {
+    lean_yoga_DirtyQueue* q = queue;
+    for (size_t i = 0; i < q->size; ++i) {
+        lean_dec_ref(q->roots[i]);
+    }
+    free(q->roots);
+    lean_yoga_free(q, sizeof(lean_yoga_DirtyQueue));
+}
+
+static void lean_yoga_Node_freeChildren(lean_yoga_Node_context* ctx) {
+    if (ctx->arena != NULL) {
+        ctx->children = NULL;
+        ctx->childrenCapacity = 0;
+        return;
+    }
+    lean_yoga_countLive(&lean_yoga_liveChildrenBytes, -(int64_t)(ctx->childrenCapacity * sizeof(lean_object*)));
+    lean_yoga_Children_free(ctx->children, ctx->childrenCapacity);
+    ctx->children = NULL;
+    ctx->childrenCapacity = 0;
+}
+
+/// Releases what the context owns besides the value, config, children and class.
+static void lean_yoga_Node_releaseCallbacks(YGNodeRef node, lean_yoga_Node_context* ctx) {
+    if (ctx->measureFunc != NULL) {
+        YGNodeSetMeasureFunc(node, NULL);
+        lean_dec_ref(ctx->measureFunc);
+        ctx->measureFunc = NULL;
+        ctx->measureKeyed = false;
+    }
+    if (ctx->baselineFunc != NULL) {
+        lean_dec_ref(ctx->baselineFunc);
+        ctx->baselineFunc = NULL;
+    }
+    ctx->baselineCached = false;
+    YGNodeSetBaselineFunc(node, NULL);
+    if (ctx->dirtiedFunc != NULL) {
+        lean_dec_ref(ctx->dirtiedFunc);
+        ctx->dirtiedFunc = NULL;
+    }
+    if (ctx->root != NULL) {
+        // A queued root is referenced by the queue, so it can't be finalized while queued
+        if (ctx->root->dirtyQueue != NULL) {
+            lean_dec_ref(ctx->root->dirtyQueue);
+        }
+        lean_yoga_free(ctx->root, sizeof(lean_yoga_Root));
+        ctx->root = NULL;
+    }
+    YGNodeSetDirtiedFunc(node, NULL);
 }
 
 static void lean_yoga_Config_foreach(void* cfg, b_lean_obj_arg f) {
@@ -61,25 +619,71 @@ static void lean_yoga_Node_finalizer(void* node) {
     lean_yoga_Node_context* ctx = YGNodeGetContext((YGNodeRef)node);
     lean_dec(ctx->value);
     lean_dec_ref(ctx->config);
+    if (ctx->styleClass != NULL) {
+        lean_yoga_StyleClass_unlink(ctx);
+    }
+    lean_yoga_Node_releaseCallbacks((YGNodeRef)node, ctx);
     size_t childCount = YGNodeGetChildCount((YGNodeRef)node);
     for (size_t i = 0; i < childCount; ++i) {
         lean_dec_ref(ctx->children[i]);
     }
-    free(ctx->children);
-    lean_yoga_free(ctx);
+    lean_yoga_Node_freeChildren(ctx);
+    lean_yoga_free(ctx, sizeof(lean_yoga_Node_context));
     YGNodeFree((YGNodeRef)node);
+    lean_yoga_countLive(&lean_yoga_liveNodes, -1);
 }
 
 static void lean_yoga_Config_finalizer(void* cfg) {
     lean_yoga_Config_context* ctx = YGConfigGetContext((YGConfigRef)cfg);
     lean_dec(ctx->value);
-    lean_yoga_free(ctx);
+    lean_yoga_free(ctx, sizeof(lean_yoga_Config_context));
     YGConfigFree((YGConfigRef)cfg);
+    lean_yoga_countLive(&lean_yoga_liveConfigs, -1);
+}
+
+static void lean_yoga_StyleClass_foreach(void* cls, b_lean_obj_arg f) {}
+
+/// Members keep their class alive, so there are none left at this point.
+static void lean_yoga_StyleClass_finalizer(void* cls) {
+    lean_yoga_free(YGNodeGetContext((YGNodeRef)cls), sizeof(lean_yoga_StyleClass_context));
+    YGNodeFree((YGNodeRef)cls);
 }
 
+static void lean_yoga_Style_initDefault(void);
+static void lean_yoga_LayoutAnimation_finalizer(void* anim);
+static void lean_yoga_LayoutAnimation_foreach(void* anim, b_lean_obj_arg f);
+static void lean_yoga_LayoutStore_finalizer(void* store);
+static void lean_yoga_LayoutStore_foreach(void* store, b_lean_obj_arg f);
+static void lean_yoga_ArenaNode_finalizer(void* node) {}
+static void lean_yoga_Arena_finalizer(void* arena);
+static void lean_yoga_TreeBuilder_finalizer(void* builder);
+static void lean_yoga_TreeBuilder_foreach(void* builder, b_lean_obj_arg f);
+static void lean_yoga_Arena_foreach(void* arena, b_lean_obj_arg f);
+
 LEAN_EXPORT lean_obj_res lean_yoga_initialize(lean_obj_arg world) {
     lean_yoga_Node_class = lean_register_external_class(lean_yoga_Node_finalizer, lean_yoga_Node_foreach);
+    lean_yoga_ArenaNode_class = lean_register_external_class(lean_yoga_ArenaNode_finalizer, lean_yoga_Node_foreach);
+    lean_yoga_Arena_class = lean_register_external_class(lean_yoga_Arena_finalizer, lean_yoga_Arena_foreach);
     lean_yoga_Config_class = lean_register_external_class(lean_yoga_Config_finalizer, lean_yoga_Config_foreach);
+    lean_yoga_StyleClass_class = lean_register_external_class(
+        lean_yoga_StyleClass_finalizer, lean_yoga_StyleClass_foreach
+    );
+    lean_yoga_DirtyQueue_class = lean_register_external_class(
+        lean_yoga_DirtyQueue_finalizer, lean_yoga_DirtyQueue_foreach
+    );
+    lean_yoga_LayoutAnimation_class = lean_register_external_class(
+        lean_yoga_LayoutAnimation_finalizer, lean_yoga_LayoutAnimation_foreach
+    );
+    lean_yoga_LayoutStore_class = lean_register_external_class(
+        lean_yoga_LayoutStore_finalizer, lean_yoga_LayoutStore_foreach
+    );
+    lean_yoga_TreeBuilder_class = lean_register_external_class(
+        lean_yoga_TreeBuilder_finalizer, lean_yoga_TreeBuilder_foreach
+    );
+    lean_yoga_Style_initDefault();
+#ifdef LEAN_YOGA_EVENTS
+    lean_yoga_events_subscribe();
+#endif
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -90,6 +694,7 @@ LEAN_EXPORT uint32_t lean_yoga_undefined(lean_obj_arg unit) {
 static inline lean_object* lean_yoga_Node_box(YGNodeRef ref, lean_yoga_Node_context ctx) {
     lean_object* obj = lean_alloc_external(lean_yoga_Node_class, ref);
     ctx.self = obj;
+    lean_yoga_countLive(&lean_yoga_liveNodes, 1);
     lean_yoga_Node_context* ctxBoxed = lean_yoga_alloc(sizeof(lean_yoga_Node_context));
     *ctxBoxed = ctx;
     YGNodeSetContext(ref, ctxBoxed);
@@ -104,6 +709,7 @@ static inline lean_object* lean_yoga_Config_box(YGConfigRef ref, lean_yoga_Confi
     lean_yoga_Config_context* ctxBoxed = lean_yoga_alloc(sizeof(lean_yoga_Config_context));
     *ctxBoxed = ctx;
     YGConfigSetContext(ref, ctxBoxed);
+    lean_yoga_countLive(&lean_yoga_liveConfigs, 1);
     return lean_alloc_external(lean_yoga_Config_class, ref);
 }
 
@@ -111,13 +717,212 @@ static inline YGConfigRef lean_yoga_Config_unbox(lean_object* cfg) {
     return (YGConfigRef)lean_get_external_data(cfg);
 }
 
+static inline YGNodeRef lean_yoga_StyleClass_unbox(lean_object* cls) {
+    return (YGNodeRef)lean_get_external_data(cls);
+}
+
+// `Float32` and enumerations are scalar fields, stored after the object fields by decreasing size.
+
 static inline lean_object* lean_yoga_Value_box(YGValue value) {
-    lean_object* ctor = lean_alloc_ctor(0, 2, 0);
-    lean_ctor_set(ctor, 0, lean_pod_Float32_box(value.value));
-    lean_ctor_set(ctor, 1, lean_box(value.unit));
+    lean_object* ctor = lean_alloc_ctor(0, 0, sizeof(uint32_t) + sizeof(uint8_t));
+    lean_ctor_set_uint32(ctor, 0, lean_pod_Float32_toBits(value.value));
+    lean_ctor_set_uint8(ctor, sizeof(uint32_t), value.unit);
+    return ctor;
+}
+
+/// Mirrors the scalar fields of `Yoga.Style`: all `Float32` fields in declaration order, then all enumerations.
+typedef struct {
+    float flex;
+    float flexGrow;
+    float flexShrink;
+    float flexBasis;
+    float width;
+    float height;
+    float minWidth;
+    float minHeight;
+    float maxWidth;
+    float maxHeight;
+    float position[YGEdgeAll + 1];
+    float margin[YGEdgeAll + 1];
+    float padding[YGEdgeAll + 1];
+    float border[YGEdgeAll + 1];
+    float gap[YGGutterAll + 1];
+    float aspectRatio;
+    uint8_t direction;
+    uint8_t flexDirection;
+    uint8_t justifyContent;
+    uint8_t alignContent;
+    uint8_t alignItems;
+    uint8_t alignSelf;
+    uint8_t positionType;
+    uint8_t flexWrap;
+    uint8_t overflow;
+    uint8_t display;
+    uint8_t flexBasisUnit;
+    uint8_t widthUnit;
+    uint8_t heightUnit;
+    uint8_t minWidthUnit;
+    uint8_t minHeightUnit;
+    uint8_t maxWidthUnit;
+    uint8_t maxHeightUnit;
+    uint8_t positionUnit[YGEdgeAll + 1];
+    uint8_t marginUnit[YGEdgeAll + 1];
+    uint8_t paddingUnit[YGEdgeAll + 1];
+} lean_yoga_Style;
+
+_Static_assert(sizeof(lean_yoga_Style) == 50 * sizeof(float) + 44, "`lean_yoga_Style` must not be padded");
+
+static inline lean_object* lean_yoga_Style_box(const lean_yoga_Style* style) {
+    lean_object* ctor = lean_alloc_ctor(0, 0, sizeof(lean_yoga_Style));
+    memcpy(lean_ctor_obj_cptr(ctor), style, sizeof(lean_yoga_Style));
     return ctor;
 }
 
+static inline const lean_yoga_Style* lean_yoga_Style_unbox(b_lean_obj_arg style) {
+    return (const lean_yoga_Style*)lean_ctor_obj_cptr(style);
+}
+
+static inline bool lean_yoga_Float_eq(float x, float y) {
+    return x == y || (isnan(x) && isnan(y));
+}
+
+static inline bool lean_yoga_Value_eq(float x, uint8_t xUnit, float y, uint8_t yUnit) {
+    return xUnit == yUnit && (xUnit == YGUnitUndefined || xUnit == YGUnitAuto || x == y);
+}
+
+static void lean_yoga_Style_get(YGNodeRef node, lean_yoga_Style* style) {
+    YGValue value;
+#define LEAN_YOGA_STYLE_GET_VALUE(field, fieldUnit, getter) \
+    value = getter; \
+    style->field = value.value; \
+    style->fieldUnit = value.unit;
+    style->direction = YGNodeStyleGetDirection(node);
+    style->flexDirection = YGNodeStyleGetFlexDirection(node);
+    style->justifyContent = YGNodeStyleGetJustifyContent(node);
+    style->alignContent = YGNodeStyleGetAlignContent(node);
+    style->alignItems = YGNodeStyleGetAlignItems(node);
+    style->alignSelf = YGNodeStyleGetAlignSelf(node);
+    style->positionType = YGNodeStyleGetPositionType(node);
+    style->flexWrap = YGNodeStyleGetFlexWrap(node);
+    style->overflow = YGNodeStyleGetOverflow(node);
+    style->display = YGNodeStyleGetDisplay(node);
+    style->flex = YGNodeStyleGetFlex(node);
+    style->flexGrow = YGNodeStyleGetFlexGrow(node);
+    style->flexShrink = YGNodeStyleGetFlexShrink(node);
+    LEAN_YOGA_STYLE_GET_VALUE(flexBasis, flexBasisUnit, YGNodeStyleGetFlexBasis(node))
+    LEAN_YOGA_STYLE_GET_VALUE(width, widthUnit, YGNodeStyleGetWidth(node))
+    LEAN_YOGA_STYLE_GET_VALUE(height, heightUnit, YGNodeStyleGetHeight(node))
+    LEAN_YOGA_STYLE_GET_VALUE(minWidth, minWidthUnit, YGNodeStyleGetMinWidth(node))
+    LEAN_YOGA_STYLE_GET_VALUE(minHeight, minHeightUnit, YGNodeStyleGetMinHeight(node))
+    LEAN_YOGA_STYLE_GET_VALUE(maxWidth, maxWidthUnit, YGNodeStyleGetMaxWidth(node))
+    LEAN_YOGA_STYLE_GET_VALUE(maxHeight, maxHeightUnit, YGNodeStyleGetMaxHeight(node))
+    for (int edge = 0; edge <= YGEdgeAll; ++edge) {
+        LEAN_YOGA_STYLE_GET_VALUE(
+            position[edge], positionUnit[edge], YGNodeStyleGetPosition(node, edge)
+        )
+        LEAN_YOGA_STYLE_GET_VALUE(
+            margin[edge], marginUnit[edge], YGNodeStyleGetMargin(node, edge)
+        )
+        LEAN_YOGA_STYLE_GET_VALUE(
+            padding[edge], paddingUnit[edge], YGNodeStyleGetPadding(node, edge)
+        )
+        style->border[edge] = YGNodeStyleGetBorder(node, edge);
+    }
+    for (int gutter = 0; gutter <= YGGutterAll; ++gutter) {
+        style->gap[gutter] = YGNodeStyleGetGap(node, gutter);
+    }
+    style->aspectRatio = YGNodeStyleGetAspectRatio(node);
+#undef LEAN_YOGA_STYLE_GET_VALUE
+}
+
+/// Calls the setters only for properties which differ from `current`.
+static void lean_yoga_Style_update(YGNodeRef node, const lean_yoga_Style* current, const lean_yoga_Style* style) {
+#define LEAN_YOGA_STYLE_SET_ENUM(field, setter) \
+    if (current->field != style->field) setter(node, style->field);
+#define LEAN_YOGA_STYLE_SET_FLOAT(field, setter) \
+    if (!lean_yoga_Float_eq(current->field, style->field)) setter(node, style->field);
+#define LEAN_YOGA_STYLE_SET_VALUE(field, fieldUnit, setPoint, setPercent, setAuto, ...) \
+    if (!lean_yoga_Value_eq(current->field, current->fieldUnit, style->field, style->fieldUnit)) { \
+        switch (style->fieldUnit) { \
+        case YGUnitPoint: setPoint(node, __VA_ARGS__ style->field); break; \
+        case YGUnitPercent: setPercent(node, __VA_ARGS__ style->field); break; \
+        case YGUnitAuto: setAuto; break; \
+        default: setPoint(node, __VA_ARGS__ YGUndefined); break; \
+        } \
+    }
+    LEAN_YOGA_STYLE_SET_ENUM(direction, YGNodeStyleSetDirection)
+    LEAN_YOGA_STYLE_SET_ENUM(flexDirection, YGNodeStyleSetFlexDirection)
+    LEAN_YOGA_STYLE_SET_ENUM(justifyContent, YGNodeStyleSetJustifyContent)
+    LEAN_YOGA_STYLE_SET_ENUM(alignContent, YGNodeStyleSetAlignContent)
+    LEAN_YOGA_STYLE_SET_ENUM(alignItems, YGNodeStyleSetAlignItems)
+    LEAN_YOGA_STYLE_SET_ENUM(alignSelf, YGNodeStyleSetAlignSelf)
+    LEAN_YOGA_STYLE_SET_ENUM(positionType, YGNodeStyleSetPositionType)
+    LEAN_YOGA_STYLE_SET_ENUM(flexWrap, YGNodeStyleSetFlexWrap)
+    LEAN_YOGA_STYLE_SET_ENUM(overflow, YGNodeStyleSetOverflow)
+    LEAN_YOGA_STYLE_SET_ENUM(display, YGNodeStyleSetDisplay)
+    LEAN_YOGA_STYLE_SET_FLOAT(flex, YGNodeStyleSetFlex)
+    LEAN_YOGA_STYLE_SET_FLOAT(flexGrow, YGNodeStyleSetFlexGrow)
+    LEAN_YOGA_STYLE_SET_FLOAT(flexShrink, YGNodeStyleSetFlexShrink)
+    LEAN_YOGA_STYLE_SET_VALUE(
+        flexBasis, flexBasisUnit, YGNodeStyleSetFlexBasis, YGNodeStyleSetFlexBasisPercent,
+        YGNodeStyleSetFlexBasisAuto(node)
+    )
+    LEAN_YOGA_STYLE_SET_VALUE(
+        width, widthUnit, YGNodeStyleSetWidth, YGNodeStyleSetWidthPercent, YGNodeStyleSetWidthAuto(node)
+    )
+    LEAN_YOGA_STYLE_SET_VALUE(
+        height, heightUnit, YGNodeStyleSetHeight, YGNodeStyleSetHeightPercent, YGNodeStyleSetHeightAuto(node)
+    )
+    LEAN_YOGA_STYLE_SET_VALUE(
+        minWidth, minWidthUnit, YGNodeStyleSetMinWidth, YGNodeStyleSetMinWidthPercent,
+        YGNodeStyleSetMinWidth(node, YGUndefined)
+    )
+    LEAN_YOGA_STYLE_SET_VALUE(
+        minHeight, minHeightUnit, YGNodeStyleSetMinHeight, YGNodeStyleSetMinHeightPercent,
+        YGNodeStyleSetMinHeight(node, YGUndefined)
+    )
+    LEAN_YOGA_STYLE_SET_VALUE(
+        maxWidth, maxWidthUnit, YGNodeStyleSetMaxWidth, YGNodeStyleSetMaxWidthPercent,
+        YGNodeStyleSetMaxWidth(node, YGUndefined)
+    )
+    LEAN_YOGA_STYLE_SET_VALUE(
+        maxHeight, maxHeightUnit, YGNodeStyleSetMaxHeight, YGNodeStyleSetMaxHeightPercent,
+        YGNodeStyleSetMaxHeight(node, YGUndefined)
+    )
+    for (int edge = 0; edge <= YGEdgeAll; ++edge) {
+        LEAN_YOGA_STYLE_SET_VALUE(
+            position[edge], positionUnit[edge], YGNodeStyleSetPosition, YGNodeStyleSetPositionPercent,
+            YGNodeStyleSetPosition(node, edge, YGUndefined), edge,
+        )
+        LEAN_YOGA_STYLE_SET_VALUE(
+            margin[edge], marginUnit[edge], YGNodeStyleSetMargin, YGNodeStyleSetMarginPercent,
+            YGNodeStyleSetMarginAuto(node, edge), edge,
+        )
+        LEAN_YOGA_STYLE_SET_VALUE(
+            padding[edge], paddingUnit[edge], YGNodeStyleSetPadding, YGNodeStyleSetPaddingPercent,
+            YGNodeStyleSetPadding(node, edge, YGUndefined), edge,
+        )
+        if (!lean_yoga_Float_eq(current->border[edge], style->border[edge])) {
+            YGNodeStyleSetBorder(node, edge, style->border[edge]);
+        }
+    }
+    for (int gutter = 0; gutter <= YGGutterAll; ++gutter) {
+        if (!lean_yoga_Float_eq(current->gap[gutter], style->gap[gutter])) {
+            YGNodeStyleSetGap(node, gutter, style->gap[gutter]);
+        }
+    }
+    LEAN_YOGA_STYLE_SET_FLOAT(aspectRatio, YGNodeStyleSetAspectRatio)
+#undef LEAN_YOGA_STYLE_SET_ENUM
+#undef LEAN_YOGA_STYLE_SET_FLOAT
+#undef LEAN_YOGA_STYLE_SET_VALUE
+}
+
+static inline void lean_yoga_Style_set(YGNodeRef node, const lean_yoga_Style* style) {
+    lean_yoga_Style current;
+    lean_yoga_Style_get(node, &current);
+    lean_yoga_Style_update(node, &current, style);
+}
+
 LEAN_EXPORT uint8_t lean_yoga_Node_beq(b_lean_obj_arg node1, b_lean_obj_arg node2) {
     return lean_yoga_Node_unbox(node1) == lean_yoga_Node_unbox(node2);
 }
@@ -134,7 +939,15 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_new(lean_obj_arg ctxVal, lean_obj_arg cf
         .config = lean_yoga_Config_box(cfg, cfgCtx),
         .children = NULL,
         .childrenCapacity = 0,
-        .measureFunc = NULL
+        .index = 0,
+        .measureFunc = NULL,
+        .styleClass = NULL,
+        .classPrev = NULL,
+        .classNext = NULL,
+        .dirtiedFunc = NULL,
+        .baselineFunc = NULL,
+        .baselineCached = false,
+        .root = NULL
     };
     YGNodeRef node = YGNodeNewWithConfig(cfg);
     return lean_io_result_mk_ok(lean_yoga_Node_box(node, ctx));
@@ -153,9 +966,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Config_setContext(b_lean_obj_arg cfg, lean_ob
     return lean_io_result_mk_ok(lean_box(0));
 }
 
-LEAN_EXPORT lean_obj_res lean_yoga_Node_newWithConfig(lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg world) {
-    YGConfigRef ygCfg = lean_yoga_Config_unbox(cfg);
-    YGNodeRef node = YGNodeNewWithConfig(ygCfg);
+static lean_object* lean_yoga_Node_alloc(lean_obj_arg ctxVal, lean_obj_arg cfg) {
+    YGNodeRef node = YGNodeNewWithConfig(lean_yoga_Config_unbox(cfg));
     lean_yoga_Node_context ctx = {
         .self = NULL,
         .value = ctxVal,
@@ -163,9 +975,21 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_newWithConfig(lean_obj_arg ctxVal, lean_
         .config = cfg,
         .children = NULL,
         .childrenCapacity = 0,
-        .measureFunc = NULL
+        .index = 0,
+        .measureFunc = NULL,
+        .styleClass = NULL,
+        .classPrev = NULL,
+        .classNext = NULL,
+        .dirtiedFunc = NULL,
+        .baselineFunc = NULL,
+        .baselineCached = false,
+        .root = NULL
     };
-    return lean_io_result_mk_ok(lean_yoga_Node_box(node, ctx));
+    return lean_yoga_Node_box(node, ctx);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_newWithConfig(lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg world) {
+    return lean_io_result_mk_ok(lean_yoga_Node_alloc(ctxVal, cfg));
 }
 
 // LEAN_EXPORT lean_obj_res lean_yoga_Node_clone(b_lean_obj_arg node, lean_obj_arg world) {
@@ -187,11 +1011,73 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_reset(b_lean_obj_arg node, lean_obj_arg
             "Cannot reset a node still attached to an owner"
         )));
     }
+    if (ctx->root != NULL && ctx->root->queued) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Cannot reset a node waiting in a dirty queue"
+        )));
+    }
+    if (ctx->styleClass != NULL) {
+        lean_yoga_StyleClass_unlink(ctx);
+    }
+    lean_yoga_Node_releaseCallbacks(ygNode, ctx);
     YGNodeReset(ygNode); // keeps config
     YGNodeSetContext(ygNode, ctx);
+#ifdef LEAN_YOGA_EVENTS
+    memset(&ctx->cacheStats, 0, sizeof(lean_yoga_CacheStats));
+#endif
     return lean_io_result_mk_ok(lean_box(0));
 }
 
+/// Makes room for `needed` children, keeping the first `childCount`.
+static void lean_yoga_Node_reserveChildren(lean_yoga_Node_context* ctx, size_t childCount, size_t needed) {
+    if (ctx->childrenCapacity >= needed) {
+        return;
+    }
+    size_t oldCapacity = ctx->childrenCapacity;
+    ctx->childrenCapacity = 2 * childCount + 1;
+    if (ctx->childrenCapacity < needed) {
+        ctx->childrenCapacity = needed;
+    }
+    if (ctx->arena != NULL) {
+        lean_object** children = lean_yoga_Arena_alloc(ctx->arena, ctx->childrenCapacity * sizeof(lean_object*));
+        if (childCount > 0) {
+            memcpy(children, ctx->children, childCount * sizeof(lean_object*));
+        }
+        ctx->children = children;
+        return;
+    }
+    lean_yoga_countLive(
+        &lean_yoga_liveChildrenBytes, (int64_t)((ctx->childrenCapacity - oldCapacity) * sizeof(lean_object*))
+    );
+    ctx->children = lean_yoga_Children_realloc(ctx->children, oldCapacity, childCount, ctx->childrenCapacity);
+    lean_yoga_countAllocation();
+}
+
+/// Updates the cached indices of the children in `[begin, end)` after they were moved.
+static inline void lean_yoga_Node_reindexChildren(lean_yoga_Node_context* ctx, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        lean_yoga_Node_context_of(ctx->children[i])->index = i;
+    }
+}
+
+/// Detaches and releases the children in `[begin, end)` without touching the Yoga node.
+static void lean_yoga_Node_releaseChildren(lean_yoga_Node_context* ctx, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        lean_yoga_Node_context_of(ctx->children[i])->parent = NULL;
+        lean_dec_ref(ctx->children[i]);
+    }
+}
+
+/// Hands the first `childCount` children of `ctx` to Yoga at once, see `lean_yoga_setChildren`.
+static void lean_yoga_Node_syncChildren(YGNodeRef ygNode, lean_yoga_Node_context* ctx, size_t childCount) {
+    YGNodeRef* ygChildren = malloc(childCount * sizeof(YGNodeRef));
+    for (size_t i = 0; i < childCount; ++i) {
+        ygChildren[i] = lean_yoga_Node_unbox(ctx->children[i]);
+    }
+    lean_yoga_setChildren(ygNode, ygChildren, childCount, NULL, 0);
+    free(ygChildren);
+}
+
 LEAN_EXPORT lean_obj_res lean_yoga_Node_insertChild(
     b_lean_obj_arg node, lean_obj_arg child, uint32_t index, lean_obj_arg world
 ) {
@@ -200,42 +1086,85 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_insertChild(
     YGNodeRef ygChild = lean_yoga_Node_unbox(child);
     lean_yoga_Node_context* childCtx = YGNodeGetContext(ygChild);
     if (YGNodeHasMeasureFunc(ygNode)) {
+        lean_dec_ref(child);
         return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
             "Yoga Node.insertChild: parent has a measure function"
         )));
     }
     if (childCtx->parent != NULL) {
+        lean_dec_ref(child);
         return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
             "Yoga Node.insertChild: child already has a parent"
         )));
     }
+    if (childCtx->arena != nodeCtx->arena) {
+        lean_dec_ref(child);
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga Node.insertChild: child belongs to another arena"
+        )));
+    }
     size_t childCount = YGNodeGetChildCount(ygNode);
     if (index >= childCount) {
         index = childCount;
     }
-    if (nodeCtx->childrenCapacity < childCount + 1) {
-        nodeCtx->childrenCapacity = 2 * childCount + 1;
-        lean_object** children = malloc(nodeCtx->childrenCapacity * sizeof(lean_object*));
-        memcpy(children, nodeCtx->children, index * sizeof(lean_object*));
-        children[index] = child;
-        memcpy(
-            children + index + 1,
-            nodeCtx->children + index,
-            (childCount - index) * sizeof(lean_object*)
-        );
-        free(nodeCtx->children);
-        nodeCtx->children = children;
-    }
-    else {
-        memmove(
-            nodeCtx->children + index + 1,
-            nodeCtx->children + index,
-            (childCount - index) * sizeof(lean_object*)
-        );
-        nodeCtx->children[index] = child;
-    }
+    lean_yoga_Node_reserveChildren(nodeCtx, childCount, childCount + 1);
+    memmove(
+        nodeCtx->children + index + 1,
+        nodeCtx->children + index,
+        (childCount - index) * sizeof(lean_object*)
+    );
+    nodeCtx->children[index] = child;
+    lean_yoga_Node_reindexChildren(nodeCtx, index + 1, childCount + 1);
     YGNodeInsertChild(ygNode, ygChild, index);
     childCtx->parent = node;
+    childCtx->index = index;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_insertChildren(
+    b_lean_obj_arg node, b_lean_obj_arg children, uint32_t index, lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* nodeCtx = YGNodeGetContext(ygNode);
+    if (YGNodeHasMeasureFunc(ygNode)) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga Node.insertChildren: parent has a measure function"
+        )));
+    }
+    size_t insertCount = lean_array_size(children);
+    // Claiming the children first also catches duplicates within `children`
+    for (size_t i = 0; i < insertCount; ++i) {
+        lean_yoga_Node_context* childCtx = lean_yoga_Node_context_of(lean_array_get_core(children, i));
+        if (childCtx->parent != NULL || childCtx->arena != nodeCtx->arena) {
+            for (size_t j = 0; j < i; ++j) {
+                lean_yoga_Node_context_of(lean_array_get_core(children, j))->parent = NULL;
+            }
+            return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+                "Yoga Node.insertChildren: a child already has a parent or belongs to another arena"
+            )));
+        }
+        childCtx->parent = node;
+    }
+    if (insertCount == 0) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    size_t childCount = YGNodeGetChildCount(ygNode);
+    if (index >= childCount) {
+        index = childCount;
+    }
+    lean_yoga_Node_reserveChildren(nodeCtx, childCount, childCount + insertCount);
+    memmove(
+        nodeCtx->children + index + insertCount,
+        nodeCtx->children + index,
+        (childCount - index) * sizeof(lean_object*)
+    );
+    for (size_t i = 0; i < insertCount; ++i) {
+        lean_object* child = lean_array_get_core(children, i);
+        lean_inc_ref(child);
+        nodeCtx->children[index + i] = child;
+    }
+    lean_yoga_Node_reindexChildren(nodeCtx, index, childCount + insertCount);
+    lean_yoga_Node_syncChildren(ygNode, nodeCtx, childCount + insertCount);
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -247,13 +1176,17 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_swapChild(
     YGNodeRef ygChild = lean_yoga_Node_unbox(child);
     lean_yoga_Node_context* childCtx = YGNodeGetContext(ygChild);
     size_t childCount = YGNodeGetChildCount(ygNode);
-    if (index >= childCount) {
+    if (index >= childCount || childCtx->parent != NULL || childCtx->arena != nodeCtx->arena) {
         return lean_io_result_mk_ok(lean_box(0));
     }
-    lean_object* otherChild = nodeCtx->children[index];
-    ((lean_yoga_Node_context*)YGNodeGetContext(lean_yoga_Node_unbox(otherChild)))->parent = NULL;
-    lean_dec_ref(otherChild);
-    YGNodeSwapChild(ygNode, ygChild, index);
+    // Unlike `YGNodeSwapChild` this also clears the owner of the replaced node
+    YGNodeRemoveChild(ygNode, lean_yoga_Node_unbox(nodeCtx->children[index]));
+    YGNodeInsertChild(ygNode, ygChild, index);
+    lean_yoga_Node_releaseChildren(nodeCtx, index, index + 1);
+    lean_inc_ref(child);
+    nodeCtx->children[index] = child;
+    childCtx->parent = node;
+    childCtx->index = index;
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -262,116 +1195,220 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_removeChild(b_lean_obj_arg node, b_lean_
     lean_yoga_Node_context* nodeCtx = YGNodeGetContext(ygNode);
     YGNodeRef ygChild = lean_yoga_Node_unbox(child);
     lean_yoga_Node_context* childCtx = YGNodeGetContext(ygChild);
-    size_t childCount = YGNodeGetChildCount(ygNode);
-    for (size_t i = 0; i < childCount; ++i) {
-        if (nodeCtx->children[i] == child) {
-            lean_dec_ref(nodeCtx->children[i]);
-            childCtx->parent = NULL;
-            memmove(
-                nodeCtx->children + i,
-                nodeCtx->children + i + 1,
-                (childCount - i - 1) * sizeof(lean_object*)
-            );
-            YGNodeRemoveChild(ygNode, ygChild);
-            break;
-        }
+    if (childCtx->parent != node) {
+        return lean_io_result_mk_ok(lean_box(0));
     }
+    size_t childCount = YGNodeGetChildCount(ygNode);
+    size_t index = childCtx->index;
+    YGNodeRemoveChild(ygNode, ygChild);
+    lean_yoga_Node_releaseChildren(nodeCtx, index, index + 1);
+    memmove(
+        nodeCtx->children + index,
+        nodeCtx->children + index + 1,
+        (childCount - index - 1) * sizeof(lean_object*)
+    );
+    lean_yoga_Node_reindexChildren(nodeCtx, index, childCount - 1);
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_removeAllChildren(b_lean_obj_arg node, lean_obj_arg world) {
     YGNodeRef ygNode = lean_yoga_Node_unbox(node);
     lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
-    for(size_t i = 0; i < YGNodeGetChildCount(ygNode); ++i) {
-        YGNodeRef ygChild = lean_yoga_Node_unbox(ctx->children[i]);
-        ((lean_yoga_Node_context*)YGNodeGetContext(ygChild))->parent = NULL;
-        lean_dec_ref(ctx->children[i]);
-    }
-    free(ctx->children);
-    ctx->children = NULL;
+    size_t childCount = YGNodeGetChildCount(ygNode);
     YGNodeRemoveAllChildren(ygNode);
+    lean_yoga_Node_releaseChildren(ctx, 0, childCount);
+    lean_yoga_Node_freeChildren(ctx);
     return lean_io_result_mk_ok(lean_box(0));
 }
 
-LEAN_EXPORT lean_obj_res lean_yoga_Node_getChild(b_lean_obj_arg node, uint32_t i, lean_obj_arg world) {
-    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
-    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
-    if (i >= YGNodeGetChildCount(ygNode)) {
+LEAN_EXPORT lean_obj_res lean_yoga_Node_removeChildAt(b_lean_obj_arg node, uint32_t index, lean_obj_arg world) {
+    lean_yoga_Node_context* nodeCtx = YGNodeGetContext(lean_yoga_Node_unbox(node));
+    if (index >= YGNodeGetChildCount(lean_yoga_Node_unbox(node))) {
         return lean_io_result_mk_ok(lean_box(0));
     }
-    lean_inc_ref(ctx->children[i]);
-    lean_object* option = lean_alloc_ctor(1, 1, 0);
-    lean_ctor_set(option, 0, ctx->children[i]);
-    return lean_io_result_mk_ok(option);
+    return lean_yoga_Node_removeChild(node, nodeCtx->children[index], world);
 }
 
-LEAN_EXPORT lean_obj_res lean_yoga_Node_getParent(b_lean_obj_arg node, lean_obj_arg world) {
-    lean_yoga_Node_context* ctx = YGNodeGetContext(lean_yoga_Node_unbox(node));
-    if (ctx->parent == NULL) {
+LEAN_EXPORT lean_obj_res lean_yoga_Node_removeChildren(
+    b_lean_obj_arg node, uint32_t start, uint32_t stop, lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* nodeCtx = YGNodeGetContext(ygNode);
+    size_t childCount = YGNodeGetChildCount(ygNode);
+    if (stop > childCount) {
+        stop = childCount;
+    }
+    if (start >= stop) {
         return lean_io_result_mk_ok(lean_box(0));
     }
-    lean_inc_ref(ctx->parent);
-    lean_object* option = lean_alloc_ctor(1, 1, 0);
-    lean_ctor_set(option, 0, ctx->parent);
-    return lean_io_result_mk_ok(option);
-}
-
-LEAN_EXPORT lean_obj_res lean_yoga_Node_getChildCount(b_lean_obj_arg node, lean_obj_arg world) {
-    return lean_io_result_mk_ok(lean_box_uint32(YGNodeGetChildCount(lean_yoga_Node_unbox(node))));
+    if (start == 0 && stop == childCount) {
+        return lean_yoga_Node_removeAllChildren(node, world);
+    }
+    // The kept children followed by the removed ones, which Yoga has to let go before they are released
+    size_t keptCount = childCount - (stop - start);
+    YGNodeRef* ygChildren = malloc(childCount * sizeof(YGNodeRef));
+    for (size_t i = 0; i < childCount; ++i) {
+        size_t slot = i < start ? i : i < stop ? keptCount + i - start : i - (stop - start);
+        ygChildren[slot] = lean_yoga_Node_unbox(nodeCtx->children[i]);
+    }
+    lean_yoga_setChildren(ygNode, ygChildren, keptCount, ygChildren + keptCount, stop - start);
+    free(ygChildren);
+    lean_yoga_Node_releaseChildren(nodeCtx, start, stop);
+    memmove(
+        nodeCtx->children + start,
+        nodeCtx->children + stop,
+        (childCount - stop) * sizeof(lean_object*)
+    );
+    lean_yoga_Node_reindexChildren(nodeCtx, start, childCount - (stop - start));
+    return lean_io_result_mk_ok(lean_box(0));
 }
 
-LEAN_EXPORT lean_obj_res lean_yoga_Node_setChildren(
-    b_lean_obj_arg node, b_lean_obj_arg children, lean_obj_arg world
+LEAN_EXPORT lean_obj_res lean_yoga_Node_moveChild(
+    b_lean_obj_arg node, uint32_t src, uint32_t dst, lean_obj_arg world
 ) {
     YGNodeRef ygNode = lean_yoga_Node_unbox(node);
     lean_yoga_Node_context* nodeCtx = YGNodeGetContext(ygNode);
-    if (YGNodeHasMeasureFunc(ygNode)) {
+    size_t childCount = YGNodeGetChildCount(ygNode);
+    if (src >= childCount) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    if (dst >= childCount) {
+        dst = childCount - 1;
+    }
+    if (src == dst) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    lean_object* child = nodeCtx->children[src];
+    if (src < dst) {
+        memmove(nodeCtx->children + src, nodeCtx->children + src + 1, (dst - src) * sizeof(lean_object*));
+        nodeCtx->children[dst] = child;
+        lean_yoga_Node_reindexChildren(nodeCtx, src, dst + 1);
+    }
+    else {
+        memmove(nodeCtx->children + dst + 1, nodeCtx->children + dst, (src - dst) * sizeof(lean_object*));
+        nodeCtx->children[dst] = child;
+        lean_yoga_Node_reindexChildren(nodeCtx, dst, src + 1);
+    }
+    // Unlike removing and reinserting it, this keeps the child's layout and dirties the node once
+    lean_yoga_Node_syncChildren(ygNode, nodeCtx, childCount);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getChild(b_lean_obj_arg node, uint32_t i, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (i >= YGNodeGetChildCount(ygNode)) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    lean_inc_ref(ctx->children[i]);
+    lean_object* option = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(option, 0, ctx->children[i]);
+    return lean_io_result_mk_ok(option);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getParent(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(lean_yoga_Node_unbox(node));
+    if (ctx->parent == NULL) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    lean_inc_ref(ctx->parent);
+    lean_object* option = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(option, 0, ctx->parent);
+    return lean_io_result_mk_ok(option);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getChildCount(b_lean_obj_arg node, lean_obj_arg world) {
+    return lean_io_result_mk_ok(lean_box_uint32(YGNodeGetChildCount(lean_yoga_Node_unbox(node))));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getChildren(b_lean_obj_arg node, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    size_t childCount = YGNodeGetChildCount(ygNode);
+    lean_object* children = lean_alloc_array(childCount, childCount);
+    for (size_t i = 0; i < childCount; ++i) {
+        lean_inc_ref(ctx->children[i]);
+        lean_array_cptr(children)[i] = ctx->children[i];
+    }
+    return lean_io_result_mk_ok(children);
+}
+
+static lean_object* lean_yoga_Node_preorder(b_lean_obj_arg node) {
+    lean_object* nodes = lean_mk_empty_array();
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    lean_object** stack = malloc(stackCapacity * sizeof(lean_object*));
+    stack[0] = node;
+    while (stackSize > 0) {
+        lean_object* top = stack[--stackSize];
+        lean_inc_ref(top);
+        nodes = lean_array_push(nodes, top);
+        YGNodeRef ygTop = lean_yoga_Node_unbox(top);
+        lean_yoga_Node_context* ctx = YGNodeGetContext(ygTop);
+        size_t childCount = YGNodeGetChildCount(ygTop);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(lean_object*));
+        }
+        for (size_t i = childCount; i > 0; --i) {
+            stack[stackSize++] = ctx->children[i - 1];
+        }
+    }
+    free(stack);
+    return nodes;
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_toPreorderArray(b_lean_obj_arg node, lean_obj_arg world) {
+    return lean_io_result_mk_ok(lean_yoga_Node_preorder(node));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_setChildren(
+    b_lean_obj_arg node, b_lean_obj_arg children, lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* nodeCtx = YGNodeGetContext(ygNode);
+    if (YGNodeHasMeasureFunc(ygNode)) {
         return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
             "Yoga Node.setChildren: parent has a measure function"
         )));
     }
     size_t childCount = YGNodeGetChildCount(ygNode);
     size_t newChildCount = lean_array_size(children);
-    YGNodeRef* ygChildren = malloc(newChildCount * sizeof(YGNodeRef));
-    if (childCount == 0) {
-        nodeCtx->children = malloc(newChildCount * sizeof(lean_object*));
-        nodeCtx->childrenCapacity = newChildCount;
-        for (size_t i = 0; i < newChildCount; ++i) {
-            lean_object* child = lean_array_get_core(children, i);
-            if (((lean_yoga_Node_context*)YGNodeGetContext(lean_yoga_Node_unbox(child)))->parent != NULL) {
-                free(ygChildren);
-                for (size_t j = 0; j < i; ++j) {
-                    lean_dec_ref(nodeCtx->children[j]);
-                    nodeCtx->children[j] = NULL;
-                }
-                return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
-                    "Yoga Node.setChildren: a child already has a parent"
-                )));
+    // Current children may be kept, so they are marked with a null parent while claiming the new ones
+    for (size_t i = 0; i < childCount; ++i) {
+        lean_yoga_Node_context_of(nodeCtx->children[i])->parent = NULL;
+    }
+    for (size_t i = 0; i < newChildCount; ++i) {
+        lean_yoga_Node_context* childCtx = lean_yoga_Node_context_of(lean_array_get_core(children, i));
+        if (childCtx->parent != NULL || childCtx->arena != nodeCtx->arena) {
+            for (size_t j = 0; j < i; ++j) {
+                lean_yoga_Node_context_of(lean_array_get_core(children, j))->parent = NULL;
+            }
+            for (size_t j = 0; j < childCount; ++j) {
+                lean_yoga_Node_context_of(nodeCtx->children[j])->parent = node;
             }
-            lean_inc_ref(child);
-            nodeCtx->children[i] = child;
-            ygChildren[i] = lean_yoga_Node_unbox(child);
+            return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+                "Yoga Node.setChildren: a child already has a parent or belongs to another arena"
+            )));
         }
+        childCtx->parent = node;
+        childCtx->index = i;
     }
-    else {
-        for (size_t i = 0; i < childCount; ++i) {
-            ((lean_yoga_Node_context*)YGNodeGetContext(lean_yoga_Node_unbox(nodeCtx->children[i])))->parent = NULL;
-            lean_dec_ref(nodeCtx->children[i]);
-        }
-        if (nodeCtx->childrenCapacity < newChildCount) {
-            nodeCtx->childrenCapacity = newChildCount;
-            free(nodeCtx->children);
-            nodeCtx->children = malloc(newChildCount * sizeof(lean_object**));
-        }
-        for (size_t i = 0; i < newChildCount; ++i) {
-            lean_object* child = lean_array_get_core(children, i);
-            lean_inc_ref(child);
-            nodeCtx->children[i] = child;
-            ygChildren[i] = lean_yoga_Node_unbox(child);
-        }
+    YGNodeRef* ygChildren = malloc(newChildCount * sizeof(YGNodeRef));
+    for (size_t i = 0; i < newChildCount; ++i) {
+        lean_object* child = lean_array_get_core(children, i);
+        lean_inc_ref(child);
+        ygChildren[i] = lean_yoga_Node_unbox(child);
     }
     YGNodeSetChildren(ygNode, ygChildren, newChildCount);
     free(ygChildren);
+    for (size_t i = 0; i < childCount; ++i) {
+        lean_dec_ref(nodeCtx->children[i]);
+    }
+    lean_yoga_Node_reserveChildren(nodeCtx, 0, newChildCount);
+    for (size_t i = 0; i < newChildCount; ++i) {
+        nodeCtx->children[i] = lean_array_get_core(children, i);
+    }
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -386,10 +1423,64 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_isReferenceBaseline(b_lean_obj_arg node,
     return lean_io_result_mk_ok(lean_box(YGNodeIsReferenceBaseline(lean_yoga_Node_unbox(node))));
 }
 
+#ifdef LEAN_YOGA_INSTRUMENT
+/// Counts the nodes visited by the pass which just laid out `root`, by their generation rather than
+/// `hasNewLayout`, which stays set on nodes the user didn't clear it on.
+static void lean_yoga_Stats_countLayout(YGNodeRef root) {
+    uint32_t generation = lean_yoga_layoutGeneration(root);
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    YGNodeRef* stack = malloc(stackCapacity * sizeof(YGNodeRef));
+    stack[0] = root;
+    while (stackSize > 0) {
+        YGNodeRef node = stack[--stackSize];
+        lean_yoga_stats.nodesVisited += 1;
+        if (lean_yoga_layoutGeneration(node) != generation) {
+            continue;
+        }
+        lean_yoga_stats.nodesWithNewLayout += 1;
+        uint32_t childCount = YGNodeGetChildCount(node);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(YGNodeRef));
+        }
+        for (uint32_t i = 0; i < childCount; ++i) {
+            stack[stackSize++] = YGNodeGetChild(node, i);
+        }
+    }
+    free(stack);
+}
+#endif
+
+/// All layout passes go through here so that they are instrumented.
+static void lean_yoga_calculateLayout(YGNodeRef node, float ownerWidth, float ownerHeight, YGDirection ownerDir) {
+#ifdef LEAN_YOGA_INSTRUMENT
+    uint64_t start = lean_yoga_nanos();
+#endif
+    LEAN_YOGA_TRACE_EVENT(
+        'B', LEAN_YOGA_TRACE_LAYOUT, node, ownerWidth, YGMeasureModeUndefined, ownerHeight, YGMeasureModeUndefined
+    );
+    YGNodeCalculateLayout(node, ownerWidth, ownerHeight, ownerDir);
+    LEAN_YOGA_TRACE_EVENT('E', LEAN_YOGA_TRACE_LAYOUT, node, 0, 0, 0, 0);
+    // Also direct layouts of a root, so that `lean_yoga_Root_flush` compares against the actual last layout
+    lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+    if (ctx != NULL && ctx->root != NULL) {
+        ctx->root->lastWidth = ownerWidth;
+        ctx->root->lastHeight = ownerHeight;
+        ctx->root->lastDir = ownerDir;
+        ctx->root->laidOut = true;
+    }
+#ifdef LEAN_YOGA_INSTRUMENT
+    lean_yoga_stats.layoutNanos += lean_yoga_nanos() - start;
+    lean_yoga_stats.layoutCalls += 1;
+    lean_yoga_Stats_countLayout(node);
+#endif
+}
+
 LEAN_EXPORT lean_obj_res lean_yoga_Node_calculateLayout(
     b_lean_obj_arg node, uint32_t avWidth, uint32_t avHeight, uint8_t ownerDir, lean_obj_arg world
 ) {
-    YGNodeCalculateLayout(
+    lean_yoga_calculateLayout(
         lean_yoga_Node_unbox(node),
         lean_pod_Float32_fromBits(avWidth),
         lean_pod_Float32_fromBits(avHeight),
@@ -399,11 +1490,14 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_calculateLayout(
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_markDirty(b_lean_obj_arg node, lean_obj_arg world) {
+    LEAN_YOGA_TRACE_EVENT('i', LEAN_YOGA_TRACE_MARK_DIRTY, lean_yoga_Node_unbox(node), 0, 0, 0, 0);
+    lean_yoga_Node_context_of(node)->baselineCached = false;
     YGNodeMarkDirty(lean_yoga_Node_unbox(node));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_markDirtyAndPropagateToDescendants(b_lean_obj_arg node, lean_obj_arg world) {
+    LEAN_YOGA_TRACE_EVENT('i', LEAN_YOGA_TRACE_MARK_DIRTY, lean_yoga_Node_unbox(node), 0, 0, 0, 0);
     YGNodeMarkDirtyAndPropagateToDescendants(lean_yoga_Node_unbox(node));
     return lean_io_result_mk_ok(lean_box(0));
 }
@@ -440,6 +1534,124 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_copyStyle(b_lean_obj_arg dst, b_lean_obj
     return lean_io_result_mk_ok(lean_box(0));
 }
 
+static inline lean_object* lean_yoga_StyleClass_box(YGNodeRef carrier) {
+    lean_yoga_StyleClass_context* ctx = lean_yoga_alloc(sizeof(lean_yoga_StyleClass_context));
+    ctx->first = NULL;
+    ctx->memberCount = 0;
+    YGNodeSetContext(carrier, ctx);
+    return lean_alloc_external(lean_yoga_StyleClass_class, carrier);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_new(b_lean_obj_arg src, lean_obj_arg world) {
+    YGNodeRef carrier = YGNodeNew();
+    YGNodeCopyStyle(carrier, lean_yoga_Node_unbox(src));
+    return lean_io_result_mk_ok(lean_yoga_StyleClass_box(carrier));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_ofStyle(b_lean_obj_arg style, lean_obj_arg world) {
+    YGNodeRef carrier = YGNodeNew();
+    lean_yoga_Style_set(carrier, lean_yoga_Style_unbox(style));
+    return lean_io_result_mk_ok(lean_yoga_StyleClass_box(carrier));
+}
+
+static void lean_yoga_StyleClass_propagate(YGNodeRef carrier) {
+    lean_yoga_StyleClass_context* ctx = YGNodeGetContext(carrier);
+    lean_object* member = ctx->first;
+    while (member != NULL) {
+        // Only marks dirty the members whose style actually changes
+        YGNodeCopyStyle(lean_yoga_Node_unbox(member), carrier);
+        member = lean_yoga_Node_context_of(member)->classNext;
+    }
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_update(b_lean_obj_arg cls, b_lean_obj_arg src, lean_obj_arg world) {
+    YGNodeRef carrier = lean_yoga_StyleClass_unbox(cls);
+    YGNodeCopyStyle(carrier, lean_yoga_Node_unbox(src));
+    lean_yoga_StyleClass_propagate(carrier);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_getStyle(b_lean_obj_arg cls, lean_obj_arg world) {
+    lean_yoga_Style style;
+    lean_yoga_Style_get(lean_yoga_StyleClass_unbox(cls), &style);
+    return lean_io_result_mk_ok(lean_yoga_Style_box(&style));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_setStyle(b_lean_obj_arg cls, b_lean_obj_arg style, lean_obj_arg world) {
+    YGNodeRef carrier = lean_yoga_StyleClass_unbox(cls);
+    lean_yoga_Style_set(carrier, lean_yoga_Style_unbox(style));
+    lean_yoga_StyleClass_propagate(carrier);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_copyStyleTo(b_lean_obj_arg cls, b_lean_obj_arg dst, lean_obj_arg world) {
+    YGNodeCopyStyle(lean_yoga_Node_unbox(dst), lean_yoga_StyleClass_unbox(cls));
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_StyleClass_getMemberCount(b_lean_obj_arg cls, lean_obj_arg world) {
+    lean_yoga_StyleClass_context* ctx = YGNodeGetContext(lean_yoga_StyleClass_unbox(cls));
+    return lean_io_result_mk_ok(lean_box_uint32(ctx->memberCount));
+}
+
+LEAN_EXPORT uint8_t lean_yoga_StyleClass_beq(b_lean_obj_arg cls1, b_lean_obj_arg cls2) {
+    return lean_yoga_StyleClass_unbox(cls1) == lean_yoga_StyleClass_unbox(cls2);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_applyClass(b_lean_obj_arg node, lean_obj_arg cls, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    YGNodeRef carrier = lean_yoga_StyleClass_unbox(cls);
+    YGNodeCopyStyle(ygNode, carrier);
+    if (ctx->styleClass == cls) {
+        lean_dec_ref(cls);
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    if (ctx->styleClass != NULL) {
+        lean_yoga_StyleClass_unlink(ctx);
+    }
+    lean_yoga_StyleClass_context* clsCtx = YGNodeGetContext(carrier);
+    ctx->styleClass = cls;
+    ctx->classNext = clsCtx->first;
+    if (clsCtx->first != NULL) {
+        lean_yoga_Node_context_of(clsCtx->first)->classPrev = node;
+    }
+    clsCtx->first = node;
+    clsCtx->memberCount += 1;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_clearClass(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(lean_yoga_Node_unbox(node));
+    if (ctx->styleClass != NULL) {
+        lean_yoga_StyleClass_unlink(ctx);
+    }
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getClass(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(lean_yoga_Node_unbox(node));
+    if (ctx->styleClass == NULL) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    lean_inc_ref(ctx->styleClass);
+    lean_object* option = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(option, 0, ctx->styleClass);
+    return lean_io_result_mk_ok(option);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getStyle(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_yoga_Style style;
+    lean_yoga_Style_get(lean_yoga_Node_unbox(node), &style);
+    return lean_io_result_mk_ok(lean_yoga_Style_box(&style));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_setStyle(b_lean_obj_arg node, b_lean_obj_arg style, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, lean_yoga_Style_set(ygNode, lean_yoga_Style_unbox(style)));
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
 LEAN_EXPORT lean_obj_res lean_yoga_Node_getContext(b_lean_obj_arg node, lean_obj_arg world) {
     lean_yoga_Node_context* ctx = YGNodeGetContext(lean_yoga_Node_unbox(node));
     lean_inc(ctx->value);
@@ -484,10 +1696,18 @@ static YGSize lean_yoga_measureFunc(
     YGNodeRef node, float width, YGMeasureMode widthMode, float height, YGMeasureMode heightMode
 ) {
     lean_yoga_Node_context* ctx = YGNodeGetContext(node);
-    lean_inc_ref(ctx->measureFunc);
+    lean_object* measureFunc = ctx->measureFunc;
+    lean_inc_ref(measureFunc);
+    if (ctx->measureKeyed) {
+        measureFunc = lean_apply_1(measureFunc, lean_box_uint64(ctx->measureKey));
+    }
     lean_inc_ref(ctx->self);
+#ifdef LEAN_YOGA_INSTRUMENT
+    uint64_t start = lean_yoga_nanos();
+#endif
+    LEAN_YOGA_TRACE_EVENT('B', LEAN_YOGA_TRACE_MEASURE, node, width, widthMode, height, heightMode);
     lean_object* res = lean_apply_6(
-        ctx->measureFunc,
+        measureFunc,
         ctx->self,
         lean_pod_Float32_box(width),
         lean_box(widthMode),
@@ -495,6 +1715,11 @@ static YGSize lean_yoga_measureFunc(
         lean_box(heightMode),
         lean_box(0)
     );
+    LEAN_YOGA_TRACE_EVENT('E', LEAN_YOGA_TRACE_MEASURE, node, 0, 0, 0, 0);
+#ifdef LEAN_YOGA_INSTRUMENT
+    lean_yoga_stats.measureNanos += lean_yoga_nanos() - start;
+    lean_yoga_stats.measureCalls += 1;
+#endif
     if(lean_io_result_is_error(res)) {
         lean_io_result_show_error(res);
         lean_dec_ref(res);
@@ -502,8 +1727,8 @@ static YGSize lean_yoga_measureFunc(
     }
     lean_object* val = lean_io_result_get_value(res);
     YGSize size = {
-        .width = lean_pod_Float32_unbox(lean_ctor_get(val, 0)),
-        .height = lean_pod_Float32_unbox(lean_ctor_get(val, 1))
+        .width = lean_pod_Float32_fromBits(lean_ctor_get_uint32(val, 0)),
+        .height = lean_pod_Float32_fromBits(lean_ctor_get_uint32(val, sizeof(uint32_t)))
     };
     lean_dec_ref(res);
     return size;
@@ -519,6 +1744,7 @@ LEAN_EXPORT lean_obj_arg lean_yoga_Node_setMeasureFunc(b_lean_obj_arg node, lean
         YGNodeSetMeasureFunc(ygNode, lean_yoga_measureFunc);
     }
     ctx->measureFunc = mf;
+    ctx->measureKeyed = false;
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -529,6 +1755,7 @@ LEAN_EXPORT lean_obj_arg lean_yoga_Node_resetMeasureFunc(b_lean_obj_arg node, le
         YGNodeSetMeasureFunc(ygNode, NULL);
         lean_dec_ref(ctx->measureFunc);
         ctx->measureFunc = NULL;
+        ctx->measureKeyed = false;
     }
     return lean_io_result_mk_ok(lean_box(0));
 }
@@ -539,14 +1766,316 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_hasBaselineFunc(b_lean_obj_arg node, lea
     ));
 }
 
-// @[extern "lean_yoga_Node_setBaselineFunc"]
-// opaque Node.setBaselineFunc (node : @& Node α β) (baselineFunc : BaselineFunc α β) : IO Unit
+static float lean_yoga_baselineFunc(YGNodeRef node, float width, float height) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+    if (
+        ctx->baselineCached &&
+        lean_yoga_Float_eq(ctx->baselineCacheWidth, width) &&
+        lean_yoga_Float_eq(ctx->baselineCacheHeight, height)
+    ) {
+        return ctx->baselineCacheValue;
+    }
+    float baseline;
+    if (ctx->baselineFunc == NULL) {
+        baseline = ctx->baselineFraction * height;
+    }
+    else {
+        LEAN_YOGA_TRACE_EVENT(
+            'B', LEAN_YOGA_TRACE_BASELINE, node, width, YGMeasureModeUndefined, height, YGMeasureModeUndefined
+        );
+        lean_inc_ref(ctx->baselineFunc);
+        lean_inc_ref(ctx->self);
+        lean_object* res = lean_apply_4(
+            ctx->baselineFunc,
+            ctx->self,
+            lean_pod_Float32_box(width),
+            lean_pod_Float32_box(height),
+            lean_box(0)
+        );
+        LEAN_YOGA_TRACE_EVENT('E', LEAN_YOGA_TRACE_BASELINE, node, 0, 0, 0, 0);
+        if (lean_io_result_is_error(res)) {
+            lean_io_result_show_error(res);
+            lean_dec_ref(res);
+            return height;
+        }
+        baseline = lean_pod_Float32_unbox(lean_io_result_get_value(res));
+        lean_dec_ref(res);
+    }
+    ctx->baselineCacheWidth = width;
+    ctx->baselineCacheHeight = height;
+    ctx->baselineCacheValue = baseline;
+    ctx->baselineCached = true;
+    return baseline;
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_setBaselineFunc(b_lean_obj_arg node, lean_obj_arg bf, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (ctx->baselineFunc != NULL) {
+        lean_dec_ref(ctx->baselineFunc);
+    }
+    ctx->baselineFunc = bf;
+    ctx->baselineCached = false;
+    YGNodeSetBaselineFunc(ygNode, lean_yoga_baselineFunc);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_invalidateBaseline(b_lean_obj_arg node, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_EVENT('i', LEAN_YOGA_TRACE_MARK_DIRTY, ygNode, 0, 0, 0, 0);
+    lean_yoga_Node_context_of(node)->baselineCached = false;
+    lean_yoga_markDirtyAndPropagate(ygNode);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_setBaselineFraction(
+    b_lean_obj_arg node, uint32_t fraction, lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (ctx->baselineFunc != NULL) {
+        lean_dec_ref(ctx->baselineFunc);
+        ctx->baselineFunc = NULL;
+    }
+    ctx->baselineFraction = lean_pod_Float32_fromBits(fraction);
+    ctx->baselineCached = false;
+    YGNodeSetBaselineFunc(ygNode, lean_yoga_baselineFunc);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_resetBaselineFunc(b_lean_obj_arg node, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (ctx->baselineFunc != NULL) {
+        lean_dec_ref(ctx->baselineFunc);
+        ctx->baselineFunc = NULL;
+    }
+    ctx->baselineCached = false;
+    YGNodeSetBaselineFunc(ygNode, NULL);
+    return lean_io_result_mk_ok(lean_box(0));
+}
 
 // @[extern "lean_yoga_Node_getDirtiedFunc"]
 // opaque Node.getDirtiedFunc (node : @& Node α β) : IO (DirtiedFunc α β)
 
-// @[extern "lean_yoga_Node_setDirtiedFunc"]
-// opaque Node.setDirtiedFunc (node : @& Node α β) (dirtiedFunc : DirtiedFunc α β) : IO Unit
+static void lean_yoga_DirtyQueue_push(lean_object* queue, lean_object* root) {
+    lean_yoga_DirtyQueue* q = lean_get_external_data(queue);
+    if (q->size == q->capacity) {
+        q->capacity = 2 * q->capacity + 1;
+        q->roots = realloc(q->roots, q->capacity * sizeof(lean_object*));
+    }
+    lean_inc_ref(root);
+    q->roots[q->size++] = root;
+}
+
+static void lean_yoga_dirtiedFunc(YGNodeRef node) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+    if (ctx->root != NULL && ctx->root->dirtyQueue != NULL && !ctx->root->queued) {
+        ctx->root->queued = true;
+        lean_yoga_DirtyQueue_push(ctx->root->dirtyQueue, ctx->self);
+    }
+    if (ctx->dirtiedFunc != NULL) {
+        lean_inc_ref(ctx->dirtiedFunc);
+        lean_inc_ref(ctx->self);
+        lean_object* res = lean_apply_2(ctx->dirtiedFunc, ctx->self, lean_box(0));
+        if (lean_io_result_is_error(res)) {
+            lean_io_result_show_error(res);
+        }
+        lean_dec_ref(res);
+    }
+}
+
+static inline void lean_yoga_Node_updateDirtiedFunc(YGNodeRef node, lean_yoga_Node_context* ctx) {
+    bool needed = ctx->dirtiedFunc != NULL || (ctx->root != NULL && ctx->root->dirtyQueue != NULL);
+    YGNodeSetDirtiedFunc(node, needed ? lean_yoga_dirtiedFunc : NULL);
+}
+
+static lean_yoga_Root* lean_yoga_Node_getRoot(lean_yoga_Node_context* ctx) {
+    if (ctx->root == NULL) {
+        ctx->root = lean_yoga_alloc(sizeof(lean_yoga_Root));
+        *ctx->root = (lean_yoga_Root){
+            .dirtyQueue = NULL,
+            .ownerWidth = YGUndefined,
+            .ownerHeight = YGUndefined,
+            .lastWidth = YGUndefined,
+            .lastHeight = YGUndefined,
+            .ownerDir = YGDirectionInherit,
+            .lastDir = YGDirectionInherit,
+            .queued = false,
+            .laidOut = false,
+            .quantize = false
+        };
+    }
+    return ctx->root;
+}
+
+static inline float lean_yoga_Root_quantize(float size, float pointScaleFactor) {
+    if (YGFloatIsUndefined(size) || pointScaleFactor <= 0) {
+        return size;
+    }
+    return roundf(size * pointScaleFactor) / pointScaleFactor;
+}
+
+/// Lays out the root with the requested parameters unless it is clean and they didn't change.
+static bool lean_yoga_Root_flush(YGNodeRef node, lean_yoga_Node_context* ctx) {
+    lean_yoga_Root* root = ctx->root;
+    float width = root->ownerWidth;
+    float height = root->ownerHeight;
+    if (root->quantize) {
+        float pointScaleFactor = YGConfigGetPointScaleFactor(lean_yoga_Config_unbox(ctx->config));
+        width = lean_yoga_Root_quantize(width, pointScaleFactor);
+        height = lean_yoga_Root_quantize(height, pointScaleFactor);
+    }
+    if (
+        root->laidOut && !YGNodeIsDirty(node) && root->lastDir == root->ownerDir &&
+        lean_yoga_Float_eq(root->lastWidth, width) && lean_yoga_Float_eq(root->lastHeight, height)
+    ) {
+        return false;
+    }
+    lean_yoga_calculateLayout(node, width, height, root->ownerDir);
+    return true;
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_setDirtiedFunc(b_lean_obj_arg node, lean_obj_arg f, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (ctx->dirtiedFunc != NULL) {
+        lean_dec_ref(ctx->dirtiedFunc);
+    }
+    ctx->dirtiedFunc = f;
+    lean_yoga_Node_updateDirtiedFunc(ygNode, ctx);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_resetDirtiedFunc(b_lean_obj_arg node, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (ctx->dirtiedFunc != NULL) {
+        lean_dec_ref(ctx->dirtiedFunc);
+        ctx->dirtiedFunc = NULL;
+    }
+    lean_yoga_Node_updateDirtiedFunc(ygNode, ctx);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_DirtyQueue_new(lean_obj_arg world) {
+    lean_yoga_DirtyQueue* q = lean_yoga_alloc(sizeof(lean_yoga_DirtyQueue));
+    *q = (lean_yoga_DirtyQueue){ .roots = NULL, .size = 0, .capacity = 0 };
+    return lean_io_result_mk_ok(lean_alloc_external(lean_yoga_DirtyQueue_class, q));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_DirtyQueue_track(
+    b_lean_obj_arg queue, b_lean_obj_arg node,
+    uint32_t ownerWidth, uint32_t ownerHeight, uint8_t ownerDir,
+    lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    lean_yoga_Root* root = lean_yoga_Node_getRoot(ctx);
+    if (root->dirtyQueue != queue) {
+        if (root->queued) {
+            return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+                "Yoga DirtyQueue.track: root is waiting in another queue"
+            )));
+        }
+        if (root->dirtyQueue != NULL) {
+            lean_dec_ref(root->dirtyQueue);
+        }
+        lean_inc_ref(queue);
+        root->dirtyQueue = queue;
+    }
+    root->ownerWidth = lean_pod_Float32_fromBits(ownerWidth);
+    root->ownerHeight = lean_pod_Float32_fromBits(ownerHeight);
+    root->ownerDir = ownerDir;
+    lean_yoga_Node_updateDirtiedFunc(ygNode, ctx);
+    // The callback only fires on a clean to dirty transition, and fresh nodes are clean but not laid out
+    bool needsLayout = YGNodeIsDirty(ygNode) || YGFloatIsUndefined(YGNodeLayoutGetWidth(ygNode));
+    if (needsLayout && !root->queued) {
+        root->queued = true;
+        lean_yoga_DirtyQueue_push(queue, node);
+    }
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_DirtyQueue_untrack(b_lean_obj_arg queue, b_lean_obj_arg node, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    lean_yoga_Root* root = ctx->root;
+    if (root == NULL || root->dirtyQueue != queue) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    if (root->queued) {
+        lean_yoga_DirtyQueue* q = lean_get_external_data(queue);
+        for (size_t i = 0; i < q->size; ++i) {
+            if (q->roots[i] == node) {
+                memmove(q->roots + i, q->roots + i + 1, (q->size - i - 1) * sizeof(lean_object*));
+                q->size -= 1;
+                lean_dec_ref(node);
+                break;
+            }
+        }
+        root->queued = false;
+    }
+    root->dirtyQueue = NULL;
+    lean_dec_ref(queue);
+    lean_yoga_Node_updateDirtiedFunc(ygNode, ctx);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_requestLayout(
+    b_lean_obj_arg node, uint32_t ownerWidth, uint32_t ownerHeight, uint8_t ownerDir, lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    lean_yoga_Root* root = lean_yoga_Node_getRoot(ctx);
+    root->ownerWidth = lean_pod_Float32_fromBits(ownerWidth);
+    root->ownerHeight = lean_pod_Float32_fromBits(ownerHeight);
+    root->ownerDir = ownerDir;
+    if (root->dirtyQueue != NULL && !root->queued) {
+        root->queued = true;
+        lean_yoga_DirtyQueue_push(root->dirtyQueue, node);
+    }
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_flushLayout(b_lean_obj_arg node, lean_obj_arg world) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Node_context* ctx = YGNodeGetContext(ygNode);
+    if (ctx->root == NULL) {
+        return lean_io_result_mk_ok(lean_box(false));
+    }
+    return lean_io_result_mk_ok(lean_box(lean_yoga_Root_flush(ygNode, ctx)));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_setLayoutQuantization(
+    b_lean_obj_arg node, uint8_t quantize, lean_obj_arg world
+) {
+    lean_yoga_Node_getRoot(lean_yoga_Node_context_of(node))->quantize = quantize;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_DirtyQueue_getPendingCount(b_lean_obj_arg queue, lean_obj_arg world) {
+    lean_yoga_DirtyQueue* q = lean_get_external_data(queue);
+    return lean_io_result_mk_ok(lean_box_uint32(q->size));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_DirtyQueue_flush(b_lean_obj_arg queue, lean_obj_arg world) {
+    lean_yoga_DirtyQueue* q = lean_get_external_data(queue);
+    // Roots dirtied by callbacks during the flush are queued for the next one
+    lean_object** roots = q->roots;
+    size_t size = q->size;
+    *q = (lean_yoga_DirtyQueue){ .roots = NULL, .size = 0, .capacity = 0 };
+    uint32_t laidOut = 0;
+    for (size_t i = 0; i < size; ++i) {
+        YGNodeRef ygRoot = lean_yoga_Node_unbox(roots[i]);
+        lean_yoga_Node_context* ctx = YGNodeGetContext(ygRoot);
+        ctx->root->queued = false;
+        laidOut += lean_yoga_Root_flush(ygRoot, ctx);
+        lean_dec_ref(roots[i]);
+    }
+    free(roots);
+    return lean_io_result_mk_ok(lean_box_uint32(laidOut));
+}
 
 // @[extern "lean_yoga_Node_getHasNewLayout"]
 // opaque Node.getHasNewLayout (node : @& Node α β) : IO Bool
@@ -586,7 +2115,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_isDirty(b_lean_obj_arg node, lean_obj_ar
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetDirection(
     b_lean_obj_arg node, uint8_t direction, lean_obj_arg world
 ) {
-    YGNodeStyleSetDirection(lean_yoga_Node_unbox(node), direction);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetDirection(ygNode, direction));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -599,7 +2129,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetDirection(b_lean_obj_arg node, l
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexDirection(
     b_lean_obj_arg node, uint8_t flexDirection, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexDirection(lean_yoga_Node_unbox(node), flexDirection);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexDirection(ygNode, flexDirection));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -612,7 +2143,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetFlexDirection(b_lean_obj_arg nod
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetJustifyContent(
     b_lean_obj_arg node, uint8_t justifyContent, lean_obj_arg world
 ) {
-    YGNodeStyleSetJustifyContent(lean_yoga_Node_unbox(node), justifyContent);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetJustifyContent(ygNode, justifyContent));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -625,7 +2157,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetJustifyContent(b_lean_obj_arg no
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetAlignContent(
     b_lean_obj_arg node, uint8_t alignContent, lean_obj_arg world
 ) {
-    YGNodeStyleSetAlignContent(lean_yoga_Node_unbox(node), alignContent);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetAlignContent(ygNode, alignContent));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -638,7 +2171,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetAlignContent(b_lean_obj_arg node
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetAlignItems(
     b_lean_obj_arg node, uint8_t alignItems, lean_obj_arg world
 ) {
-    YGNodeStyleSetAlignItems(lean_yoga_Node_unbox(node), alignItems);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetAlignItems(ygNode, alignItems));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -651,7 +2185,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetAlignItems(b_lean_obj_arg node,
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetAlignSelf(
     b_lean_obj_arg node, uint8_t alignSelf, lean_obj_arg world
 ) {
-    YGNodeStyleSetAlignSelf(lean_yoga_Node_unbox(node), alignSelf);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetAlignSelf(ygNode, alignSelf));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -664,7 +2199,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetAlignSelf(b_lean_obj_arg node, l
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetPositionType(
     b_lean_obj_arg node, uint8_t positionType, lean_obj_arg world
 ) {
-    YGNodeStyleSetPositionType(lean_yoga_Node_unbox(node), positionType);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetPositionType(ygNode, positionType));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -677,7 +2213,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetPositionType(b_lean_obj_arg node
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexWrap(
     b_lean_obj_arg node, uint8_t flexWrap, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexWrap(lean_yoga_Node_unbox(node), flexWrap);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexWrap(ygNode, flexWrap));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -690,7 +2227,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetFlexWrap(b_lean_obj_arg node, le
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetOverflow(
     b_lean_obj_arg node, uint8_t overflow, lean_obj_arg world
 ) {
-    YGNodeStyleSetOverflow(lean_yoga_Node_unbox(node), overflow);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetOverflow(ygNode, overflow));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -703,7 +2241,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetOverflow(b_lean_obj_arg node, le
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetDisplay(
     b_lean_obj_arg node, uint8_t display, lean_obj_arg world
 ) {
-    YGNodeStyleSetDisplay(lean_yoga_Node_unbox(node), display);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetDisplay(ygNode, display));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -716,7 +2255,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetDisplay(b_lean_obj_arg node, lea
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlex(
     b_lean_obj_arg node, uint32_t flex, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlex(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(flex));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlex(ygNode, lean_pod_Float32_fromBits(flex)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -729,7 +2269,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetFlex(b_lean_obj_arg node, lean_o
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexGrow(
     b_lean_obj_arg node, uint32_t flexGrow, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexGrow(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(flexGrow));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexGrow(ygNode, lean_pod_Float32_fromBits(flexGrow)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -742,7 +2283,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetFlexGrow(b_lean_obj_arg node, le
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexShrink(
     b_lean_obj_arg node, uint32_t flexShrink, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexShrink(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(flexShrink));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexShrink(ygNode, lean_pod_Float32_fromBits(flexShrink)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -755,21 +2297,24 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetFlexShrink(b_lean_obj_arg node,
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexBasis(
     b_lean_obj_arg node, uint32_t flexBasis, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexBasis(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(flexBasis));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexBasis(ygNode, lean_pod_Float32_fromBits(flexBasis)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexBasisPercent(
     b_lean_obj_arg node, uint32_t flexBasis, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexBasisPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(flexBasis));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexBasisPercent(ygNode, lean_pod_Float32_fromBits(flexBasis)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetFlexBasisAuto(
     b_lean_obj_arg node, lean_obj_arg world
 ) {
-    YGNodeStyleSetFlexBasisAuto(lean_yoga_Node_unbox(node));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetFlexBasisAuto(ygNode));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -782,14 +2327,16 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetFlexBasis(b_lean_obj_arg node, l
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetPosition(
     b_lean_obj_arg node, uint8_t edge, uint32_t position, lean_obj_arg world
 ) {
-    YGNodeStyleSetPosition(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(position));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetPosition(ygNode, edge, lean_pod_Float32_fromBits(position)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetPositionPercent(
     b_lean_obj_arg node, uint8_t edge, uint32_t position, lean_obj_arg world
 ) {
-    YGNodeStyleSetPositionPercent(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(position));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetPositionPercent(ygNode, edge, lean_pod_Float32_fromBits(position)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -804,21 +2351,24 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetPosition(
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMargin(
     b_lean_obj_arg node, uint8_t edge, uint32_t margin, lean_obj_arg world
 ) {
-    YGNodeStyleSetMargin(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(margin));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMargin(ygNode, edge, lean_pod_Float32_fromBits(margin)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMarginPercent(
     b_lean_obj_arg node, uint8_t edge, uint32_t margin, lean_obj_arg world
 ) {
-    YGNodeStyleSetMarginPercent(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(margin));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMarginPercent(ygNode, edge, lean_pod_Float32_fromBits(margin)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMarginAuto(
     b_lean_obj_arg node, uint8_t edge, lean_obj_arg world
 ) {
-    YGNodeStyleSetMarginAuto(lean_yoga_Node_unbox(node), edge);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMarginAuto(ygNode, edge));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -833,14 +2383,16 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetMargin(
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetPadding(
     b_lean_obj_arg node, uint8_t edge, uint32_t padding, lean_obj_arg world
 ) {
-    YGNodeStyleSetPadding(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(padding));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetPadding(ygNode, edge, lean_pod_Float32_fromBits(padding)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetPaddingPercent(
     b_lean_obj_arg node, uint8_t edge, uint32_t padding, lean_obj_arg world
 ) {
-    YGNodeStyleSetPaddingPercent(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(padding));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetPaddingPercent(ygNode, edge, lean_pod_Float32_fromBits(padding)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -855,7 +2407,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetPadding(
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetBorder(
     b_lean_obj_arg node, uint8_t edge, uint32_t border, lean_obj_arg world
 ) {
-    YGNodeStyleSetBorder(lean_yoga_Node_unbox(node), edge, lean_pod_Float32_fromBits(border));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetBorder(ygNode, edge, lean_pod_Float32_fromBits(border)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -870,7 +2423,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetBorder(
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetGap(
     b_lean_obj_arg node, uint8_t gutter, uint32_t gapLength, lean_obj_arg world
 ) {
-    YGNodeStyleSetGap(lean_yoga_Node_unbox(node), gutter, lean_pod_Float32_fromBits(gapLength));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetGap(ygNode, gutter, lean_pod_Float32_fromBits(gapLength)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -885,19 +2439,22 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetGap(
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetWidth(
     b_lean_obj_arg node, uint32_t width, lean_obj_arg world
 ) {
-    YGNodeStyleSetWidth(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(width));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetWidth(ygNode, lean_pod_Float32_fromBits(width)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetWidthPercent(
     b_lean_obj_arg node, uint32_t width, lean_obj_arg world
 ) {
-    YGNodeStyleSetWidthPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(width));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetWidthPercent(ygNode, lean_pod_Float32_fromBits(width)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetWidthAuto(b_lean_obj_arg node, lean_obj_arg world) {
-    YGNodeStyleSetWidthAuto(lean_yoga_Node_unbox(node));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetWidthAuto(ygNode));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -910,19 +2467,22 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetWidth(b_lean_obj_arg node, lean_
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetHeight(
     b_lean_obj_arg node, uint32_t height, lean_obj_arg world
 ) {
-    YGNodeStyleSetHeight(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(height));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetHeight(ygNode, lean_pod_Float32_fromBits(height)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetHeightPercent(
     b_lean_obj_arg node, uint32_t height, lean_obj_arg world
 ) {
-    YGNodeStyleSetHeightPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(height));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetHeightPercent(ygNode, lean_pod_Float32_fromBits(height)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetHeightAuto(b_lean_obj_arg node, lean_obj_arg world) {
-    YGNodeStyleSetHeightAuto(lean_yoga_Node_unbox(node));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetHeightAuto(ygNode));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -935,14 +2495,16 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetHeight(b_lean_obj_arg node, lean
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMinWidth(
     b_lean_obj_arg node, uint32_t minWidth, lean_obj_arg world
 ) {
-    YGNodeStyleSetMinWidth(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(minWidth));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMinWidth(ygNode, lean_pod_Float32_fromBits(minWidth)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMinWidthPercent(
     b_lean_obj_arg node, uint32_t minWidth, lean_obj_arg world
 ) {
-    YGNodeStyleSetMinWidthPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(minWidth));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMinWidthPercent(ygNode, lean_pod_Float32_fromBits(minWidth)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -955,14 +2517,16 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetMinWidth(b_lean_obj_arg node, le
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMinHeight(
     b_lean_obj_arg node, uint32_t minHeight, lean_obj_arg world
 ) {
-    YGNodeStyleSetMinHeight(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(minHeight));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMinHeight(ygNode, lean_pod_Float32_fromBits(minHeight)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMinHeightPercent(
     b_lean_obj_arg node, uint32_t minHeight, lean_obj_arg world
 ) {
-    YGNodeStyleSetMinHeightPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(minHeight));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMinHeightPercent(ygNode, lean_pod_Float32_fromBits(minHeight)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -975,14 +2539,16 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetMinHeight(b_lean_obj_arg node, l
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMaxWidth(
     b_lean_obj_arg node, uint32_t maxWidth, lean_obj_arg world
 ) {
-    YGNodeStyleSetMaxWidth(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(maxWidth));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMaxWidth(ygNode, lean_pod_Float32_fromBits(maxWidth)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMaxWidthPercent(
     b_lean_obj_arg node, uint32_t maxWidth, lean_obj_arg world
 ) {
-    YGNodeStyleSetMaxWidthPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(maxWidth));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMaxWidthPercent(ygNode, lean_pod_Float32_fromBits(maxWidth)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -995,14 +2561,16 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetMaxWidth(b_lean_obj_arg node, le
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMaxHeight(
     b_lean_obj_arg node, uint32_t maxHeight, lean_obj_arg world
 ) {
-    YGNodeStyleSetMaxHeight(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(maxHeight));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMaxHeight(ygNode, lean_pod_Float32_fromBits(maxHeight)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetMaxHeightPercent(
     b_lean_obj_arg node, uint32_t maxHeight, lean_obj_arg world
 ) {
-    YGNodeStyleSetMaxHeightPercent(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(maxHeight));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetMaxHeightPercent(ygNode, lean_pod_Float32_fromBits(maxHeight)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -1015,7 +2583,8 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_styleGetMaxHeight(b_lean_obj_arg node, l
 LEAN_EXPORT lean_obj_res lean_yoga_Node_styleSetAspectRatio(
     b_lean_obj_arg node, uint32_t aspectRatio, lean_obj_arg world
 ) {
-    YGNodeStyleSetAspectRatio(lean_yoga_Node_unbox(node), lean_pod_Float32_fromBits(aspectRatio));
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    LEAN_YOGA_TRACE_STYLE_SET(ygNode, YGNodeStyleSetAspectRatio(ygNode, lean_pod_Float32_fromBits(aspectRatio)));
     return lean_io_result_mk_ok(lean_box(0));
 }
 
@@ -1097,6 +2666,90 @@ LEAN_EXPORT lean_obj_res lean_yoga_Node_layoutGetPadding(
     ));
 }
 
+/// Whether descendants of the node are clipped to it instead of extending the content of its ancestors.
+static inline bool lean_yoga_clipsContent(YGNodeRef node) {
+    return YGNodeStyleGetOverflow(node) != YGOverflowVisible;
+}
+
+/// Grows `bounds` (left, top, right, bottom) to contain the given box.
+static inline void lean_yoga_Bounds_add(float* bounds, float left, float top, float right, float bottom) {
+    bounds[0] = fminf(bounds[0], left);
+    bounds[1] = fminf(bounds[1], top);
+    bounds[2] = fmaxf(bounds[2], right);
+    bounds[3] = fmaxf(bounds[3], bottom);
+}
+
+/// Recomputes content extents of the nodes reached through nodes with a new layout, children first.
+/// Other subtrees kept their layout since the last update, so their stored extents are reused.
+LEAN_EXPORT lean_obj_res lean_yoga_Node_updateContentSizes(b_lean_obj_arg node, lean_obj_arg world) {
+    size_t capacity = 64;
+    size_t size = 1;
+    YGNodeRef* order = malloc(capacity * sizeof(YGNodeRef));
+    order[0] = lean_yoga_Node_unbox(node);
+    // Preorder of the nodes to update, consumed backwards so that children precede their parent
+    for (size_t i = 0; i < size; ++i) {
+        YGNodeRef n = order[i];
+        uint32_t childCount = YGNodeGetChildCount(n);
+        if (size + childCount > capacity) {
+            capacity = 2 * capacity + childCount;
+            order = realloc(order, capacity * sizeof(YGNodeRef));
+        }
+        for (uint32_t j = 0; j < childCount; ++j) {
+            YGNodeRef child = YGNodeGetChild(n, j);
+            if (YGNodeGetHasNewLayout(child)) {
+                order[size++] = child;
+            }
+        }
+    }
+    for (size_t i = size; i-- > 0;) {
+        YGNodeRef n = order[i];
+        float bounds[4] = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+        uint32_t childCount = YGNodeGetChildCount(n);
+        for (uint32_t j = 0; j < childCount; ++j) {
+            YGNodeRef child = YGNodeGetChild(n, j);
+            if (YGNodeStyleGetDisplay(child) == YGDisplayNone) {
+                continue;
+            }
+            float left = YGNodeLayoutGetLeft(child);
+            float top = YGNodeLayoutGetTop(child);
+            lean_yoga_Bounds_add(
+                bounds,
+                left - YGNodeLayoutGetMargin(child, YGEdgeLeft),
+                top - YGNodeLayoutGetMargin(child, YGEdgeTop),
+                left + YGNodeLayoutGetWidth(child) + YGNodeLayoutGetMargin(child, YGEdgeRight),
+                top + YGNodeLayoutGetHeight(child) + YGNodeLayoutGetMargin(child, YGEdgeBottom)
+            );
+            if (!lean_yoga_clipsContent(child) && YGNodeGetChildCount(child) > 0) {
+                lean_yoga_Node_context* childCtx = YGNodeGetContext(child);
+                const float* content = childCtx->contentBounds;
+                lean_yoga_Bounds_add(
+                    bounds, left + content[0], top + content[1], left + content[2], top + content[3]
+                );
+            }
+        }
+        lean_yoga_Node_context* ctx = YGNodeGetContext(n);
+        // Without children the content is empty, at the node's corner
+        if (bounds[0] > bounds[2]) {
+            memset(ctx->contentBounds, 0, sizeof(ctx->contentBounds));
+        }
+        else {
+            memcpy(ctx->contentBounds, bounds, sizeof(ctx->contentBounds));
+        }
+    }
+    free(order);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_layoutGetContentSize(b_lean_obj_arg node, lean_obj_arg world) {
+    const float* bounds = lean_yoga_Node_context_of(node)->contentBounds;
+    float rect[4] = { bounds[0], bounds[1], bounds[2] - bounds[0], bounds[3] - bounds[1] };
+    lean_object* obj = lean_alloc_ctor(0, 0, 4 * sizeof(uint32_t));
+    for (size_t k = 0; k < 4; ++k) {
+        lean_ctor_set_uint32(obj, k * sizeof(uint32_t), lean_pod_Float32_toBits(rect[k]));
+    }
+    return lean_io_result_mk_ok(obj);
+}
+
 LEAN_EXPORT lean_obj_res lean_yoga_assert(uint8_t cond, b_lean_obj_arg msg, lean_obj_arg world) {
     YGAssert(cond, lean_string_cstr(msg));
     return lean_io_result_mk_ok(lean_box(0));
@@ -1216,6 +2869,1650 @@ LEAN_EXPORT uint32_t lean_yoga_roundValueToPixelGrid(
     );
 }
 
+LEAN_EXPORT lean_obj_res lean_yoga_getAllocationCount(lean_obj_arg world) {
+    return lean_io_result_mk_ok(lean_box_uint64(lean_yoga_getAllocations()));
+}
+
+LEAN_EXPORT uint8_t lean_yoga_SlabStats_isEnabled(lean_obj_arg unit) {
+#ifdef LEAN_YOGA_ALLOC_SLAB
+    return true;
+#else
+    return false;
+#endif
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_SlabStats_get(lean_obj_arg world) {
+    uint64_t threads = 0;
+    uint64_t pages = 0;
+    uint64_t reservedBytes = 0;
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t fallbacks = 0;
+#ifdef LEAN_YOGA_ALLOC_SLAB
+    for (lean_yoga_SlabCache* cache = atomic_load(&lean_yoga_slabCaches); cache != NULL; cache = cache->next) {
+        threads += 1;
+        pages += atomic_load_explicit(&cache->pages, memory_order_relaxed);
+        allocations += atomic_load_explicit(&cache->allocations, memory_order_relaxed);
+        frees += atomic_load_explicit(&cache->frees, memory_order_relaxed);
+    }
+    reservedBytes = pages * LEAN_YOGA_SLAB_PAGE_SIZE;
+    fallbacks = atomic_load_explicit(&lean_yoga_slabFallbacks, memory_order_relaxed);
+#endif
+    lean_object* stats = lean_alloc_ctor(0, 0, 6 * sizeof(uint64_t));
+    lean_ctor_set_uint64(stats, 0, threads);
+    lean_ctor_set_uint64(stats, sizeof(uint64_t), pages);
+    lean_ctor_set_uint64(stats, 2 * sizeof(uint64_t), reservedBytes);
+    lean_ctor_set_uint64(stats, 3 * sizeof(uint64_t), allocations);
+    lean_ctor_set_uint64(stats, 4 * sizeof(uint64_t), frees);
+    lean_ctor_set_uint64(stats, 5 * sizeof(uint64_t), fallbacks);
+    return lean_io_result_mk_ok(stats);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_getLiveCounts(lean_obj_arg world) {
+    lean_object* counts = lean_alloc_ctor(0, 0, 4 * sizeof(uint64_t));
+    lean_ctor_set_uint64(counts, 0, atomic_load_explicit(&lean_yoga_liveNodes, memory_order_relaxed));
+    lean_ctor_set_uint64(counts, sizeof(uint64_t), atomic_load_explicit(&lean_yoga_liveConfigs, memory_order_relaxed));
+    lean_ctor_set_uint64(
+        counts, 2 * sizeof(uint64_t), atomic_load_explicit(&lean_yoga_liveContexts, memory_order_relaxed)
+    );
+    lean_ctor_set_uint64(
+        counts, 3 * sizeof(uint64_t), atomic_load_explicit(&lean_yoga_liveChildrenBytes, memory_order_relaxed)
+    );
+    return lean_io_result_mk_ok(counts);
+}
+
+static int lean_yoga_comparePointers(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t)*(void* const*)a;
+    uintptr_t y = (uintptr_t)*(void* const*)b;
+    return (x > y) - (x < y);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_memoryUsage(b_lean_obj_arg root, lean_obj_arg world) {
+    uint64_t nodeCount = 0;
+    uint64_t contextBytes = 0;
+    uint64_t childrenBytes = 0;
+    uint64_t wastedChildrenBytes = 0;
+    uint64_t callbackBytes = 0;
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    lean_object** stack = malloc(stackCapacity * sizeof(lean_object*));
+    stack[0] = root;
+    size_t configCapacity = 16;
+    size_t configCount = 0;
+    lean_object** configs = malloc(configCapacity * sizeof(lean_object*));
+    while (stackSize > 0) {
+        YGNodeRef node = lean_yoga_Node_unbox(stack[--stackSize]);
+        lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+        size_t childCount = YGNodeGetChildCount(node);
+        nodeCount += 1;
+        contextBytes += sizeof(lean_yoga_Node_context);
+        if (ctx->root != NULL) {
+            contextBytes += sizeof(lean_yoga_Root);
+        }
+        childrenBytes += ctx->childrenCapacity * sizeof(lean_object*);
+        wastedChildrenBytes += (ctx->childrenCapacity - childCount) * sizeof(lean_object*);
+        lean_object* callbacks[3] = { ctx->measureFunc, ctx->baselineFunc, ctx->dirtiedFunc };
+        for (size_t i = 0; i < 3; ++i) {
+            if (callbacks[i] != NULL) {
+                callbackBytes += lean_object_byte_size(callbacks[i]);
+            }
+        }
+        if (configCount == configCapacity) {
+            configCapacity *= 2;
+            configs = realloc(configs, configCapacity * sizeof(lean_object*));
+        }
+        configs[configCount++] = ctx->config;
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(lean_object*));
+        }
+        for (size_t i = 0; i < childCount; ++i) {
+            stack[stackSize++] = ctx->children[i];
+        }
+    }
+    free(stack);
+    qsort(configs, configCount, sizeof(lean_object*), lean_yoga_comparePointers);
+    uint64_t distinctConfigs = 0;
+    for (size_t i = 0; i < configCount; ++i) {
+        distinctConfigs += i == 0 || configs[i] != configs[i - 1];
+    }
+    free(configs);
+
+    lean_object* usage = lean_alloc_ctor(0, 0, 7 * sizeof(uint64_t));
+    lean_ctor_set_uint64(usage, 0, nodeCount);
+    lean_ctor_set_uint64(usage, sizeof(uint64_t), nodeCount * lean_yoga_sizeofYGNode());
+    lean_ctor_set_uint64(usage, 2 * sizeof(uint64_t), contextBytes);
+    lean_ctor_set_uint64(usage, 3 * sizeof(uint64_t), childrenBytes);
+    lean_ctor_set_uint64(usage, 4 * sizeof(uint64_t), wastedChildrenBytes);
+    lean_ctor_set_uint64(
+        usage, 5 * sizeof(uint64_t),
+        distinctConfigs * (lean_yoga_sizeofYGConfig() + sizeof(lean_yoga_Config_context))
+    );
+    lean_ctor_set_uint64(usage, 6 * sizeof(uint64_t), callbackBytes);
+    return lean_io_result_mk_ok(usage);
+}
+
+LEAN_EXPORT uint8_t lean_yoga_Stats_isEnabled(lean_obj_arg unit) {
+#ifdef LEAN_YOGA_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Stats_get(lean_obj_arg world) {
+    lean_object* stats = lean_alloc_ctor(0, 0, 7 * sizeof(uint64_t));
+#ifdef LEAN_YOGA_INSTRUMENT
+    lean_ctor_set_uint64(stats, 0 * sizeof(uint64_t), lean_yoga_stats.layoutCalls);
+    lean_ctor_set_uint64(stats, 1 * sizeof(uint64_t), lean_yoga_stats.layoutNanos);
+    lean_ctor_set_uint64(stats, 2 * sizeof(uint64_t), lean_yoga_stats.measureCalls);
+    lean_ctor_set_uint64(stats, 3 * sizeof(uint64_t), lean_yoga_stats.measureNanos);
+    lean_ctor_set_uint64(stats, 4 * sizeof(uint64_t), lean_yoga_stats.nodesVisited);
+    lean_ctor_set_uint64(stats, 5 * sizeof(uint64_t), lean_yoga_stats.nodesWithNewLayout);
+#else
+    memset(lean_ctor_scalar_cptr(stats), 0, 6 * sizeof(uint64_t));
+#endif
+    lean_ctor_set_uint64(
+        stats, 6 * sizeof(uint64_t), lean_yoga_getAllocations() - lean_yoga_allocationCountAtReset
+    );
+    return lean_io_result_mk_ok(stats);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Stats_reset(lean_obj_arg world) {
+#ifdef LEAN_YOGA_INSTRUMENT
+    memset(&lean_yoga_stats, 0, sizeof(lean_yoga_Stats));
+#endif
+    lean_yoga_allocationCountAtReset = lean_yoga_getAllocations();
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+// # Serialization
+
+/*
+Little-endian tree format:
+    magic "YGLT", u16 version, u16 flags, u32 node count,
+    then every node in preorder:
+        varint child count, u8 node flags, u8 style property count,
+        (u8 property index, f32 or u8 value) for every property differing from `lean_yoga_Style_default`,
+        f32 left, top, width, height if `LEAN_YOGA_TREE_LAYOUT` is set.
+Property indices enumerate the floats and then the enumerations of `lean_yoga_Style`.
+*/
+
+#define LEAN_YOGA_TREE_MAGIC 0x544C4759u // "YGLT"
+#define LEAN_YOGA_TREE_VERSION 1
+#define LEAN_YOGA_TREE_LAYOUT 1
+#define LEAN_YOGA_NODE_TEXT 1
+#define LEAN_YOGA_NODE_REFERENCE_BASELINE 2
+#define LEAN_YOGA_STYLE_FLOAT_COUNT 50
+#define LEAN_YOGA_STYLE_ENUM_COUNT 44
+
+static lean_yoga_Style lean_yoga_Style_default;
+
+static void lean_yoga_Style_initDefault(void) {
+    YGNodeRef node = YGNodeNew();
+    lean_yoga_Style_get(node, &lean_yoga_Style_default);
+    YGNodeFree(node);
+}
+
+static inline float* lean_yoga_Style_floats(lean_yoga_Style* style) {
+    return (float*)style;
+}
+
+static inline uint8_t* lean_yoga_Style_enums(lean_yoga_Style* style) {
+    return (uint8_t*)style + LEAN_YOGA_STYLE_FLOAT_COUNT * sizeof(float);
+}
+
+/// The largest value of each enumeration of `lean_yoga_Style`, the rest are units.
+static const uint8_t lean_yoga_Style_enumMax[] = {
+    YGDirectionRTL,
+    YGFlexDirectionRowReverse,
+    YGJustifySpaceEvenly,
+    YGAlignSpaceAround,
+    YGAlignSpaceAround,
+    YGAlignSpaceAround,
+    YGPositionTypeAbsolute,
+    YGWrapWrapReverse,
+    YGOverflowScroll,
+    YGDisplayNone,
+};
+
+static inline bool lean_yoga_Style_enumValid(uint8_t index, uint8_t value) {
+    size_t named = sizeof(lean_yoga_Style_enumMax) / sizeof(lean_yoga_Style_enumMax[0]);
+    return value <= (index < named ? lean_yoga_Style_enumMax[index] : YGUnitAuto);
+}
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+} lean_yoga_Writer;
+
+static inline uint8_t* lean_yoga_Writer_reserve(lean_yoga_Writer* w, size_t n) {
+    if (w->size + n > w->capacity) {
+        w->capacity = 2 * w->capacity + n;
+        w->data = realloc(w->data, w->capacity);
+    }
+    uint8_t* p = w->data + w->size;
+    w->size += n;
+    return p;
+}
+
+static inline void lean_yoga_Writer_u8(lean_yoga_Writer* w, uint8_t x) {
+    *lean_yoga_Writer_reserve(w, 1) = x;
+}
+
+static inline void lean_yoga_Writer_u32(lean_yoga_Writer* w, uint32_t x) {
+    uint8_t* p = lean_yoga_Writer_reserve(w, 4);
+    p[0] = x;
+    p[1] = x >> 8;
+    p[2] = x >> 16;
+    p[3] = x >> 24;
+}
+
+static inline void lean_yoga_Writer_f32(lean_yoga_Writer* w, float x) {
+    lean_yoga_Writer_u32(w, lean_pod_Float32_toBits(x));
+}
+
+static inline void lean_yoga_Writer_varint(lean_yoga_Writer* w, uint32_t x) {
+    while (x >= 0x80) {
+        lean_yoga_Writer_u8(w, (x & 0x7F) | 0x80);
+        x >>= 7;
+    }
+    lean_yoga_Writer_u8(w, x);
+}
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+    // Write stored layout into the nodes instead of skipping it
+    bool restoreLayout;
+} lean_yoga_Reader;
+
+static inline bool lean_yoga_Reader_has(lean_yoga_Reader* r, size_t n) {
+    if (r->ok && (size_t)(r->end - r->p) >= n) {
+        return true;
+    }
+    r->ok = false;
+    return false;
+}
+
+static inline uint8_t lean_yoga_Reader_u8(lean_yoga_Reader* r) {
+    return lean_yoga_Reader_has(r, 1) ? *r->p++ : 0;
+}
+
+static inline uint16_t lean_yoga_Reader_u16(lean_yoga_Reader* r) {
+    if (!lean_yoga_Reader_has(r, 2)) return 0;
+    uint16_t x = r->p[0] | (uint16_t)r->p[1] << 8;
+    r->p += 2;
+    return x;
+}
+
+static inline uint32_t lean_yoga_Reader_u32(lean_yoga_Reader* r) {
+    if (!lean_yoga_Reader_has(r, 4)) return 0;
+    uint32_t x = r->p[0] | (uint32_t)r->p[1] << 8 | (uint32_t)r->p[2] << 16 | (uint32_t)r->p[3] << 24;
+    r->p += 4;
+    return x;
+}
+
+static inline float lean_yoga_Reader_f32(lean_yoga_Reader* r) {
+    return lean_pod_Float32_fromBits(lean_yoga_Reader_u32(r));
+}
+
+static inline uint32_t lean_yoga_Reader_varint(lean_yoga_Reader* r) {
+    uint32_t x = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = lean_yoga_Reader_u8(r);
+        x |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return x;
+    }
+    r->ok = false;
+    return 0;
+}
+
+static void lean_yoga_Writer_node(lean_yoga_Writer* w, YGNodeRef node, uint16_t flags) {
+    lean_yoga_Writer_varint(w, YGNodeGetChildCount(node));
+    lean_yoga_Writer_u8(w,
+        (YGNodeGetNodeType(node) == YGNodeTypeText ? LEAN_YOGA_NODE_TEXT : 0) |
+        (YGNodeIsReferenceBaseline(node) ? LEAN_YOGA_NODE_REFERENCE_BASELINE : 0)
+    );
+    lean_yoga_Style style;
+    lean_yoga_Style_get(node, &style);
+    float* floats = lean_yoga_Style_floats(&style);
+    uint8_t* enums = lean_yoga_Style_enums(&style);
+    float* defaultFloats = lean_yoga_Style_floats(&lean_yoga_Style_default);
+    uint8_t* defaultEnums = lean_yoga_Style_enums(&lean_yoga_Style_default);
+    size_t countOffset = w->size;
+    uint8_t count = 0;
+    lean_yoga_Writer_u8(w, 0);
+    for (uint8_t i = 0; i < LEAN_YOGA_STYLE_FLOAT_COUNT; ++i) {
+        if (!lean_yoga_Float_eq(floats[i], defaultFloats[i])) {
+            lean_yoga_Writer_u8(w, i);
+            lean_yoga_Writer_f32(w, floats[i]);
+            count += 1;
+        }
+    }
+    for (uint8_t i = 0; i < LEAN_YOGA_STYLE_ENUM_COUNT; ++i) {
+        if (enums[i] != defaultEnums[i]) {
+            lean_yoga_Writer_u8(w, LEAN_YOGA_STYLE_FLOAT_COUNT + i);
+            lean_yoga_Writer_u8(w, enums[i]);
+            count += 1;
+        }
+    }
+    w->data[countOffset] = count;
+    if (flags & LEAN_YOGA_TREE_LAYOUT) {
+        lean_yoga_Writer_f32(w, YGNodeLayoutGetLeft(node));
+        lean_yoga_Writer_f32(w, YGNodeLayoutGetTop(node));
+        lean_yoga_Writer_f32(w, YGNodeLayoutGetWidth(node));
+        lean_yoga_Writer_f32(w, YGNodeLayoutGetHeight(node));
+    }
+}
+
+/// Appends the whole subtree, traversing it without recursion so that deep chains are fine.
+static void lean_yoga_Writer_tree(lean_yoga_Writer* w, YGNodeRef root, uint16_t flags) {
+    size_t headerOffset = w->size;
+    lean_yoga_Writer_u32(w, LEAN_YOGA_TREE_MAGIC);
+    lean_yoga_Writer_u8(w, LEAN_YOGA_TREE_VERSION & 0xFF);
+    lean_yoga_Writer_u8(w, LEAN_YOGA_TREE_VERSION >> 8);
+    lean_yoga_Writer_u8(w, flags & 0xFF);
+    lean_yoga_Writer_u8(w, flags >> 8);
+    lean_yoga_Writer_u32(w, 0);
+    uint32_t nodeCount = 0;
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    YGNodeRef* stack = malloc(stackCapacity * sizeof(YGNodeRef));
+    stack[0] = root;
+    while (stackSize > 0) {
+        YGNodeRef node = stack[--stackSize];
+        lean_yoga_Writer_node(w, node, flags);
+        nodeCount += 1;
+        uint32_t childCount = YGNodeGetChildCount(node);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(YGNodeRef));
+        }
+        for (uint32_t i = childCount; i > 0; --i) {
+            stack[stackSize++] = YGNodeGetChild(node, i - 1);
+        }
+    }
+    free(stack);
+    uint8_t* countPtr = w->data + headerOffset + 8;
+    countPtr[0] = nodeCount;
+    countPtr[1] = nodeCount >> 8;
+    countPtr[2] = nodeCount >> 16;
+    countPtr[3] = nodeCount >> 24;
+}
+
+typedef struct {
+    lean_object* node;
+    uint32_t remaining;
+} lean_yoga_Reader_frame;
+
+/// Reads one node and its style; returns `NULL` when the data is malformed.
+static lean_object* lean_yoga_Reader_node(
+    lean_yoga_Reader* r, uint16_t flags, b_lean_obj_arg ctxVal, b_lean_obj_arg cfg,
+    uint32_t maxChildCount, uint32_t* childCount
+) {
+    *childCount = lean_yoga_Reader_varint(r);
+    if (*childCount > maxChildCount) {
+        r->ok = false;
+    }
+    uint8_t nodeFlags = lean_yoga_Reader_u8(r);
+    uint8_t count = lean_yoga_Reader_u8(r);
+    lean_yoga_Style style = lean_yoga_Style_default;
+    float* floats = lean_yoga_Style_floats(&style);
+    uint8_t* enums = lean_yoga_Style_enums(&style);
+    for (uint8_t i = 0; i < count && r->ok; ++i) {
+        uint8_t index = lean_yoga_Reader_u8(r);
+        if (index < LEAN_YOGA_STYLE_FLOAT_COUNT) {
+            floats[index] = lean_yoga_Reader_f32(r);
+        }
+        else if (index < LEAN_YOGA_STYLE_FLOAT_COUNT + LEAN_YOGA_STYLE_ENUM_COUNT) {
+            uint8_t value = lean_yoga_Reader_u8(r);
+            if (!lean_yoga_Style_enumValid(index - LEAN_YOGA_STYLE_FLOAT_COUNT, value)) {
+                r->ok = false;
+            }
+            enums[index - LEAN_YOGA_STYLE_FLOAT_COUNT] = value;
+        }
+        else {
+            r->ok = false;
+        }
+    }
+    float layout[4];
+    if (flags & LEAN_YOGA_TREE_LAYOUT) {
+        for (size_t i = 0; i < 4; ++i) {
+            layout[i] = lean_yoga_Reader_f32(r);
+        }
+    }
+    if (!r->ok) {
+        return NULL;
+    }
+    lean_inc(ctxVal);
+    lean_inc_ref(cfg);
+    lean_object* node = lean_yoga_Node_alloc(ctxVal, cfg);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Style_set(ygNode, &style);
+    if (nodeFlags & LEAN_YOGA_NODE_TEXT) {
+        YGNodeSetNodeType(ygNode, YGNodeTypeText);
+    }
+    if (nodeFlags & LEAN_YOGA_NODE_REFERENCE_BASELINE) {
+        YGNodeSetIsReferenceBaseline(ygNode, true);
+    }
+    if (r->restoreLayout && (flags & LEAN_YOGA_TREE_LAYOUT)) {
+        lean_yoga_restoreLayout(ygNode, layout[0], layout[1], layout[2], layout[3]);
+    }
+    lean_yoga_Node_reserveChildren(YGNodeGetContext(ygNode), 0, *childCount);
+    return node;
+}
+
+/// Rebuilds a tree written by `lean_yoga_Writer_tree`.
+/// Returns the root, or `NULL` and an error message when the data is malformed.
+static lean_object* lean_yoga_Reader_tree(
+    lean_yoga_Reader* r, b_lean_obj_arg ctxVal, b_lean_obj_arg cfg, const char** error
+) {
+    if (lean_yoga_Reader_u32(r) != LEAN_YOGA_TREE_MAGIC) {
+        *error = "Yoga Node.deserialize: not a serialized tree";
+        return NULL;
+    }
+    if (lean_yoga_Reader_u16(r) != LEAN_YOGA_TREE_VERSION) {
+        *error = "Yoga Node.deserialize: unsupported format version";
+        return NULL;
+    }
+    uint16_t flags = lean_yoga_Reader_u16(r);
+    uint32_t nodeCount = lean_yoga_Reader_u32(r);
+    *error = "Yoga Node.deserialize: malformed data";
+    // Each node takes at least 3 bytes, so the count bounds the reserved children arrays
+    if (!r->ok || nodeCount == 0 || nodeCount > (size_t)(r->end - r->p) / 3) {
+        return NULL;
+    }
+    uint32_t childCount;
+    lean_object* root = lean_yoga_Reader_node(r, flags, ctxVal, cfg, nodeCount - 1, &childCount);
+    if (root == NULL) {
+        return NULL;
+    }
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    lean_yoga_Reader_frame* stack = malloc(stackCapacity * sizeof(lean_yoga_Reader_frame));
+    stack[0] = (lean_yoga_Reader_frame){ .node = root, .remaining = childCount };
+    uint32_t readCount = 1;
+    while (stackSize > 0) {
+        lean_yoga_Reader_frame* top = &stack[stackSize - 1];
+        if (top->remaining == 0) {
+            stackSize -= 1;
+            continue;
+        }
+        top->remaining -= 1;
+        if (readCount == nodeCount) {
+            r->ok = false;
+            break;
+        }
+        lean_object* child = lean_yoga_Reader_node(r, flags, ctxVal, cfg, nodeCount - readCount - 1, &childCount);
+        if (child == NULL) {
+            break;
+        }
+        readCount += 1;
+        YGNodeRef ygParent = lean_yoga_Node_unbox(top->node);
+        lean_yoga_Node_context* parentCtx = YGNodeGetContext(ygParent);
+        uint32_t index = YGNodeGetChildCount(ygParent);
+        parentCtx->children[index] = child;
+        lean_yoga_Node_context_of(child)->parent = top->node;
+        lean_yoga_Node_context_of(child)->index = index;
+        YGNodeInsertChild(ygParent, lean_yoga_Node_unbox(child), index);
+        if (childCount > 0) {
+            if (stackSize == stackCapacity) {
+                stackCapacity *= 2;
+                stack = realloc(stack, stackCapacity * sizeof(lean_yoga_Reader_frame));
+            }
+            stack[stackSize++] = (lean_yoga_Reader_frame){ .node = child, .remaining = childCount };
+        }
+    }
+    free(stack);
+    if (!r->ok || readCount != nodeCount) {
+        lean_dec_ref(root);
+        return NULL;
+    }
+    return root;
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_serialize(b_lean_obj_arg node, uint8_t withLayout, lean_obj_arg world) {
+    lean_yoga_Writer w = { .data = NULL, .size = 0, .capacity = 0 };
+    lean_yoga_Writer_tree(&w, lean_yoga_Node_unbox(node), withLayout ? LEAN_YOGA_TREE_LAYOUT : 0);
+    lean_object* bytes = lean_alloc_sarray(1, w.size, w.size);
+    memcpy(lean_sarray_cptr(bytes), w.data, w.size);
+    free(w.data);
+    return lean_io_result_mk_ok(bytes);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_deserialize(
+    b_lean_obj_arg bytes, lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg world
+) {
+    const uint8_t* data = lean_sarray_cptr(bytes);
+    lean_yoga_Reader r = { .p = data, .end = data + lean_sarray_size(bytes), .ok = true };
+    const char* error;
+    lean_object* root = lean_yoga_Reader_tree(&r, ctxVal, cfg, &error);
+    lean_dec(ctxVal);
+    lean_dec_ref(cfg);
+    if (root == NULL) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(error)));
+    }
+    if (r.p != r.end) {
+        lean_dec_ref(root);
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga Node.deserialize: trailing data"
+        )));
+    }
+    return lean_io_result_mk_ok(root);
+}
+
+/// Computed layout in preorder: u32 node count, then f32 left, top, width, height of every node.
+LEAN_EXPORT lean_obj_res lean_yoga_Node_encodeLayout(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_yoga_Writer w = { .data = NULL, .size = 0, .capacity = 0 };
+    lean_yoga_Writer_u32(&w, 0);
+    uint32_t nodeCount = 0;
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    YGNodeRef* stack = malloc(stackCapacity * sizeof(YGNodeRef));
+    stack[0] = lean_yoga_Node_unbox(node);
+    while (stackSize > 0) {
+        YGNodeRef n = stack[--stackSize];
+        lean_yoga_Writer_f32(&w, YGNodeLayoutGetLeft(n));
+        lean_yoga_Writer_f32(&w, YGNodeLayoutGetTop(n));
+        lean_yoga_Writer_f32(&w, YGNodeLayoutGetWidth(n));
+        lean_yoga_Writer_f32(&w, YGNodeLayoutGetHeight(n));
+        nodeCount += 1;
+        uint32_t childCount = YGNodeGetChildCount(n);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(YGNodeRef));
+        }
+        for (uint32_t i = childCount; i > 0; --i) {
+            stack[stackSize++] = YGNodeGetChild(n, i - 1);
+        }
+    }
+    free(stack);
+    w.data[0] = nodeCount;
+    w.data[1] = nodeCount >> 8;
+    w.data[2] = nodeCount >> 16;
+    w.data[3] = nodeCount >> 24;
+    lean_object* bytes = lean_alloc_sarray(1, w.size, w.size);
+    memcpy(lean_sarray_cptr(bytes), w.data, w.size);
+    free(w.data);
+    return lean_io_result_mk_ok(bytes);
+}
+
+/// Builds a tree encoded at compile time by `yoga!`, returning its nodes in preorder.
+LEAN_EXPORT lean_obj_res lean_yoga_Template_instantiate(
+    b_lean_obj_arg bytes, lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg world
+) {
+    const uint8_t* data = lean_sarray_cptr(bytes);
+    lean_yoga_Reader r = { .p = data, .end = data + lean_sarray_size(bytes), .ok = true };
+    const char* error;
+    lean_object* root = lean_yoga_Reader_tree(&r, ctxVal, cfg, &error);
+    lean_dec(ctxVal);
+    lean_dec_ref(cfg);
+    if (root == NULL || r.p != r.end) {
+        if (root != NULL) {
+            lean_dec_ref(root);
+        }
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga Template.instantiate: malformed template"
+        )));
+    }
+    lean_object* nodes = lean_yoga_Node_preorder(root);
+    lean_dec_ref(root);
+    return lean_io_result_mk_ok(nodes);
+}
+
+/*
+Snapshot file: magic "YGLS", u16 version, u16 owner direction, f32 owner width, f32 owner height,
+since version 2 the root's cached layout: f32 available width, f32 available height,
+u8 width measure mode, u8 height measure mode, u16 reserved,
+then the tree with layout as written by `lean_yoga_Writer_tree`.
+*/
+
+#define LEAN_YOGA_SNAPSHOT_MAGIC 0x534C4759u // "YGLS"
+#define LEAN_YOGA_SNAPSHOT_VERSION 2
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_saveSnapshot(
+    b_lean_obj_arg node, b_lean_obj_arg path,
+    uint32_t ownerWidth, uint32_t ownerHeight, uint8_t ownerDir,
+    lean_obj_arg world
+) {
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_calculateLayout(
+        ygNode,
+        lean_pod_Float32_fromBits(ownerWidth),
+        lean_pod_Float32_fromBits(ownerHeight),
+        ownerDir
+    );
+    lean_yoga_Writer w = { .data = NULL, .size = 0, .capacity = 0 };
+    lean_yoga_Writer_u32(&w, LEAN_YOGA_SNAPSHOT_MAGIC);
+    lean_yoga_Writer_u8(&w, LEAN_YOGA_SNAPSHOT_VERSION & 0xFF);
+    lean_yoga_Writer_u8(&w, LEAN_YOGA_SNAPSHOT_VERSION >> 8);
+    lean_yoga_Writer_u8(&w, ownerDir);
+    lean_yoga_Writer_u8(&w, 0);
+    lean_yoga_Writer_u32(&w, ownerWidth);
+    lean_yoga_Writer_u32(&w, ownerHeight);
+    float availableWidth;
+    float availableHeight;
+    uint8_t widthMode;
+    uint8_t heightMode;
+    lean_yoga_getCachedLayout(ygNode, &availableWidth, &availableHeight, &widthMode, &heightMode);
+    lean_yoga_Writer_f32(&w, availableWidth);
+    lean_yoga_Writer_f32(&w, availableHeight);
+    lean_yoga_Writer_u8(&w, widthMode);
+    lean_yoga_Writer_u8(&w, heightMode);
+    lean_yoga_Writer_u8(&w, 0);
+    lean_yoga_Writer_u8(&w, 0);
+    lean_yoga_Writer_tree(&w, ygNode, LEAN_YOGA_TREE_LAYOUT);
+    FILE* file = fopen(lean_string_cstr(path), "wb");
+    if (file == NULL) {
+        free(w.data);
+        return lean_io_result_mk_error(lean_decode_io_error(errno, path));
+    }
+    size_t written = fwrite(w.data, 1, w.size, file);
+    free(w.data);
+    if (fclose(file) != 0 || written != w.size) {
+        return lean_io_result_mk_error(lean_decode_io_error(errno, path));
+    }
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/// Resolves layout directions of a subtree whose layout was restored and marks its nodes clean,
+/// after attaching children dirtied them.
+static void lean_yoga_Node_markRestored(YGNodeRef root, YGDirection ownerDir) {
+    typedef struct {
+        YGNodeRef node;
+        YGDirection ownerDir;
+    } frame;
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    frame* stack = malloc(stackCapacity * sizeof(frame));
+    stack[0] = (frame){ .node = root, .ownerDir = ownerDir };
+    while (stackSize > 0) {
+        frame f = stack[--stackSize];
+        YGDirection direction = YGNodeStyleGetDirection(f.node);
+        if (direction == YGDirectionInherit) {
+            direction = f.ownerDir != YGDirectionInherit ? f.ownerDir : YGDirectionLTR;
+        }
+        lean_yoga_markRestored(f.node, direction, f.ownerDir);
+        uint32_t childCount = YGNodeGetChildCount(f.node);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(frame));
+        }
+        for (uint32_t i = 0; i < childCount; ++i) {
+            stack[stackSize++] = (frame){ .node = YGNodeGetChild(f.node, i), .ownerDir = direction };
+        }
+    }
+    free(stack);
+}
+
+static lean_object* lean_yoga_Snapshot_read(
+    const uint8_t* data, size_t size, b_lean_obj_arg ctxVal, b_lean_obj_arg cfg, const char** error
+) {
+    lean_yoga_Reader r = { .p = data, .end = data + size, .ok = true, .restoreLayout = true };
+    if (lean_yoga_Reader_u32(&r) != LEAN_YOGA_SNAPSHOT_MAGIC) {
+        *error = "Yoga Node.loadSnapshot: not a layout snapshot";
+        return NULL;
+    }
+    if (lean_yoga_Reader_u16(&r) != LEAN_YOGA_SNAPSHOT_VERSION) {
+        *error = "Yoga Node.loadSnapshot: unsupported snapshot version";
+        return NULL;
+    }
+    uint8_t ownerDir = lean_yoga_Reader_u8(&r);
+    lean_yoga_Reader_u8(&r);
+    if (ownerDir > YGDirectionRTL) {
+        *error = "Yoga Node.loadSnapshot: malformed data";
+        return NULL;
+    }
+    // The owner size isn't needed, the root's cache below stands in for its layout
+    lean_yoga_Reader_f32(&r);
+    lean_yoga_Reader_f32(&r);
+    float availableWidth = lean_yoga_Reader_f32(&r);
+    float availableHeight = lean_yoga_Reader_f32(&r);
+    uint8_t widthMode = lean_yoga_Reader_u8(&r);
+    uint8_t heightMode = lean_yoga_Reader_u8(&r);
+    lean_yoga_Reader_u16(&r);
+    if (!r.ok || widthMode > YGMeasureModeAtMost || heightMode > YGMeasureModeAtMost) {
+        *error = "Yoga Node.loadSnapshot: malformed data";
+        return NULL;
+    }
+    lean_object* root = lean_yoga_Reader_tree(&r, ctxVal, cfg, error);
+    if (root == NULL) {
+        return NULL;
+    }
+    if (r.p != r.end) {
+        lean_dec_ref(root);
+        *error = "Yoga Node.loadSnapshot: trailing data";
+        return NULL;
+    }
+    YGNodeRef ygRoot = lean_yoga_Node_unbox(root);
+    lean_yoga_Node_markRestored(ygRoot, ownerDir);
+    // A layout with the saved owner size hits the root's cache and visits nothing else
+    lean_yoga_setCachedLayout(ygRoot, availableWidth, availableHeight, widthMode, heightMode);
+    return root;
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_loadSnapshot(
+    b_lean_obj_arg path, lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg world
+) {
+    const char* error = NULL;
+    lean_object* root = NULL;
+    int errnum = 0;
+#ifndef _WIN32
+    int fd = open(lean_string_cstr(path), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        errnum = errno;
+    }
+    else if (st.st_size == 0) {
+        error = "Yoga Node.loadSnapshot: not a layout snapshot";
+    }
+    else {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            errnum = errno;
+        }
+        else {
+            root = lean_yoga_Snapshot_read(data, st.st_size, ctxVal, cfg, &error);
+            munmap(data, st.st_size);
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+#else
+    FILE* file = fopen(lean_string_cstr(path), "rb");
+    if (file == NULL) {
+        errnum = errno;
+    }
+    else {
+        lean_yoga_Writer w = { .data = NULL, .size = 0, .capacity = 0 };
+        size_t n;
+        do {
+            uint8_t* chunk = lean_yoga_Writer_reserve(&w, 65536);
+            n = fread(chunk, 1, 65536, file);
+            w.size -= 65536 - n;
+        } while (n > 0);
+        if (ferror(file)) {
+            errnum = errno;
+        }
+        else {
+            root = lean_yoga_Snapshot_read(w.data, w.size, ctxVal, cfg, &error);
+        }
+        free(w.data);
+        fclose(file);
+    }
+#endif
+    lean_dec(ctxVal);
+    lean_dec_ref(cfg);
+    if (errnum != 0) {
+        return lean_io_result_mk_error(lean_decode_io_error(errnum, path));
+    }
+    if (root == NULL) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(error)));
+    }
+    return lean_io_result_mk_ok(root);
+}
+
+// # Tracing
+
+#ifdef LEAN_YOGA_TRACE
+static void lean_yoga_Writer_str(lean_yoga_Writer* w, const char* str) {
+    size_t n = strlen(str);
+    memcpy(lean_yoga_Writer_reserve(w, n), str, n);
+}
+
+static void lean_yoga_Writer_traceEvent(lean_yoga_Writer* w, uint32_t tid, const lean_yoga_TraceEvent* e) {
+    static const char* names[] = { "calculateLayout", "measure", "baseline", "markDirty" };
+    static const char* modes[] = { "undefined", "exactly", "atMost" };
+    char buf[320];
+    int n = snprintf(
+        buf, sizeof(buf),
+        "{\"name\":\"%s\",\"cat\":\"yoga\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+        names[e->kind], e->phase, e->nanos / 1000.0, tid
+    );
+    if (e->phase == 'i') {
+        n += snprintf(buf + n, sizeof(buf) - n, ",\"s\":\"t\",\"args\":{\"node\":\"%p\"}", e->node);
+    }
+    else if (e->phase == 'B' && e->kind == LEAN_YOGA_TRACE_LAYOUT) {
+        n += snprintf(
+            buf + n, sizeof(buf) - n, ",\"args\":{\"node\":\"%p\",\"width\":\"%g\",\"height\":\"%g\"}",
+            e->node, e->width, e->height
+        );
+    }
+    else if (e->phase == 'B') {
+        n += snprintf(
+            buf + n, sizeof(buf) - n,
+            ",\"args\":{\"node\":\"%p\",\"width\":\"%g\",\"widthMode\":\"%s\",\"height\":\"%g\",\"heightMode\":\"%s\"}",
+            e->node, e->width, modes[e->widthMode % 3], e->height, modes[e->heightMode % 3]
+        );
+    }
+    snprintf(buf + n, sizeof(buf) - n, "}");
+    lean_yoga_Writer_str(w, buf);
+}
+#endif
+
+LEAN_EXPORT uint8_t lean_yoga_Trace_isEnabled(lean_obj_arg unit) {
+#ifdef LEAN_YOGA_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Trace_setEnabled(uint8_t enabled, lean_obj_arg world) {
+#ifdef LEAN_YOGA_TRACE
+    atomic_store(&lean_yoga_traceEnabled, enabled);
+#endif
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Trace_clear(lean_obj_arg world) {
+#ifdef LEAN_YOGA_TRACE
+    for (
+        lean_yoga_TraceBuffer* buffer = atomic_load(&lean_yoga_traceBuffers);
+        buffer != NULL;
+        buffer = buffer->next
+    ) {
+        atomic_store(&buffer->start, atomic_load_explicit(&buffer->head, memory_order_acquire));
+    }
+#endif
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Trace_toJson(lean_obj_arg world) {
+#ifdef LEAN_YOGA_TRACE
+    lean_yoga_Writer w = { .data = NULL, .size = 0, .capacity = 0 };
+    lean_yoga_Writer_str(&w, "{\"traceEvents\":[");
+    bool first = true;
+    for (
+        lean_yoga_TraceBuffer* buffer = atomic_load(&lean_yoga_traceBuffers);
+        buffer != NULL;
+        buffer = buffer->next
+    ) {
+        uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        uint64_t start = atomic_load(&buffer->start);
+        if (head - start > LEAN_YOGA_TRACE_CAPACITY) {
+            start = head - LEAN_YOGA_TRACE_CAPACITY;
+        }
+        for (uint64_t i = start; i < head; ++i) {
+            lean_yoga_TraceEvent event = buffer->events[i & (LEAN_YOGA_TRACE_CAPACITY - 1)];
+            // The producer may have wrapped around and be rewriting the slot while it was copied
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&buffer->head, memory_order_relaxed) - i >= LEAN_YOGA_TRACE_CAPACITY) {
+                continue;
+            }
+            if (!first) {
+                lean_yoga_Writer_u8(&w, ',');
+            }
+            first = false;
+            lean_yoga_Writer_traceEvent(&w, buffer->tid, &event);
+        }
+    }
+    lean_yoga_Writer_str(&w, "],\"displayTimeUnit\":\"ns\"}");
+    lean_yoga_Writer_u8(&w, 0);
+    lean_object* json = lean_mk_string((const char*)w.data);
+    free(w.data);
+    return lean_io_result_mk_ok(json);
+#else
+    return lean_io_result_mk_ok(lean_mk_string("{\"traceEvents\":[]}"));
+#endif
+}
+
+// # Cache statistics
+
+#ifdef LEAN_YOGA_EVENTS
+// Called from the event subscriber in `internal.cpp`
+
+void lean_yoga_events_onLayoutPassStart(YGNodeRef root) {
+    lean_yoga_currentPass = atomic_fetch_add_explicit(&lean_yoga_layoutPass, 1, memory_order_relaxed) + 1;
+}
+
+/// @param layoutType `facebook::yoga::LayoutType`
+void lean_yoga_events_onNodeLayout(YGNodeRef node, int layoutType) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+    if (ctx == NULL) return;
+    switch (layoutType) {
+        case 0: ctx->cacheStats.layouts += 1; break;
+        case 1: ctx->cacheStats.measures += 1; break;
+        case 2: ctx->cacheStats.cachedLayouts += 1; break;
+        case 3: ctx->cacheStats.cachedMeasures += 1; break;
+    }
+}
+
+void lean_yoga_events_onMeasureCallbackEnd(YGNodeRef node) {
+    lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+    if (ctx == NULL) return;
+    lean_yoga_CacheStats* stats = &ctx->cacheStats;
+    if (stats->lastPass != lean_yoga_currentPass) {
+        stats->lastPass = lean_yoga_currentPass;
+        stats->passMeasureCallbacks = 0;
+    }
+    stats->measureCallbacks += 1;
+    stats->passMeasureCallbacks += 1;
+    if (stats->passMeasureCallbacks > stats->maxPassMeasureCallbacks) {
+        stats->maxPassMeasureCallbacks = stats->passMeasureCallbacks;
+    }
+}
+#endif
+
+LEAN_EXPORT uint8_t lean_yoga_CacheStats_isEnabled(lean_obj_arg unit) {
+#ifdef LEAN_YOGA_EVENTS
+    return true;
+#else
+    return false;
+#endif
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_getCacheStats(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_object* stats = lean_alloc_ctor(0, 0, 6 * sizeof(uint64_t));
+#ifdef LEAN_YOGA_EVENTS
+    lean_yoga_CacheStats* s = &lean_yoga_Node_context_of(node)->cacheStats;
+    lean_ctor_set_uint64(stats, 0 * sizeof(uint64_t), s->layouts);
+    lean_ctor_set_uint64(stats, 1 * sizeof(uint64_t), s->measures);
+    lean_ctor_set_uint64(stats, 2 * sizeof(uint64_t), s->cachedLayouts);
+    lean_ctor_set_uint64(stats, 3 * sizeof(uint64_t), s->cachedMeasures);
+    lean_ctor_set_uint64(stats, 4 * sizeof(uint64_t), s->measureCallbacks);
+    lean_ctor_set_uint64(stats, 5 * sizeof(uint64_t), s->maxPassMeasureCallbacks);
+#else
+    memset(lean_ctor_scalar_cptr(stats), 0, 6 * sizeof(uint64_t));
+#endif
+    return lean_io_result_mk_ok(stats);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_resetCacheStats(b_lean_obj_arg node, lean_obj_arg world) {
+#ifdef LEAN_YOGA_EVENTS
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    YGNodeRef* stack = malloc(stackCapacity * sizeof(YGNodeRef));
+    stack[0] = lean_yoga_Node_unbox(node);
+    while (stackSize > 0) {
+        YGNodeRef top = stack[--stackSize];
+        lean_yoga_Node_context* ctx = YGNodeGetContext(top);
+        memset(&ctx->cacheStats, 0, sizeof(lean_yoga_CacheStats));
+        uint32_t childCount = YGNodeGetChildCount(top);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(YGNodeRef));
+        }
+        for (uint32_t i = 0; i < childCount; ++i) {
+            stack[stackSize++] = YGNodeGetChild(top, i);
+        }
+    }
+    free(stack);
+#endif
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+// # Layout buffers and animation
+
+#define LEAN_YOGA_LAYOUT_COLUMNS 5 // left, top, width, height, opacity
+
+/// Columns of absolute rectangles of the nodes of a subtree in preorder.
+typedef struct {
+    size_t size;
+    size_t capacity;
+    lean_object** nodes; // borrowed
+    float* columns[LEAN_YOGA_LAYOUT_COLUMNS];
+} lean_yoga_LayoutColumns;
+
+static void lean_yoga_LayoutColumns_free(lean_yoga_LayoutColumns* c) {
+    free(c->nodes);
+    for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+        free(c->columns[k]);
+    }
+}
+
+static void lean_yoga_LayoutColumns_push(
+    lean_yoga_LayoutColumns* c, lean_object* node, float left, float top, float width, float height
+) {
+    if (c->size == c->capacity) {
+        c->capacity = 2 * c->capacity + 16;
+        c->nodes = realloc(c->nodes, c->capacity * sizeof(lean_object*));
+        for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+            c->columns[k] = realloc(c->columns[k], c->capacity * sizeof(float));
+        }
+    }
+    c->nodes[c->size] = node;
+    c->columns[0][c->size] = left;
+    c->columns[1][c->size] = top;
+    c->columns[2][c->size] = width;
+    c->columns[3][c->size] = height;
+    c->columns[4][c->size] = 1;
+    c->size += 1;
+}
+
+typedef struct {
+    lean_object* node;
+    float left;
+    float top;
+} lean_yoga_LayoutFrame;
+
+/// Collects the absolute layout of the subtree, relative to the owner of `root`.
+static void lean_yoga_LayoutColumns_collect(lean_yoga_LayoutColumns* c, lean_object* root) {
+    size_t stackCapacity = 64;
+    size_t stackSize = 1;
+    lean_yoga_LayoutFrame* stack = malloc(stackCapacity * sizeof(lean_yoga_LayoutFrame));
+    stack[0] = (lean_yoga_LayoutFrame){ .node = root, .left = 0, .top = 0 };
+    while (stackSize > 0) {
+        lean_yoga_LayoutFrame frame = stack[--stackSize];
+        YGNodeRef node = lean_yoga_Node_unbox(frame.node);
+        lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+        float left = frame.left + YGNodeLayoutGetLeft(node);
+        float top = frame.top + YGNodeLayoutGetTop(node);
+        lean_yoga_LayoutColumns_push(c, frame.node, left, top, YGNodeLayoutGetWidth(node), YGNodeLayoutGetHeight(node));
+        size_t childCount = YGNodeGetChildCount(node);
+        if (stackSize + childCount > stackCapacity) {
+            stackCapacity = 2 * stackCapacity + childCount;
+            stack = realloc(stack, stackCapacity * sizeof(lean_yoga_LayoutFrame));
+        }
+        for (size_t i = childCount; i > 0; --i) {
+            stack[stackSize++] = (lean_yoga_LayoutFrame){ .node = ctx->children[i - 1], .left = left, .top = top };
+        }
+    }
+    free(stack);
+}
+
+// `LayoutBuffer` has `FloatArray` fields left, top, width, height and opacity
+static lean_object* lean_yoga_LayoutBuffer_alloc(size_t size) {
+    lean_object* buffer = lean_alloc_ctor(0, LEAN_YOGA_LAYOUT_COLUMNS, 0);
+    for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+        lean_ctor_set(buffer, k, lean_alloc_sarray(sizeof(double), size, size));
+    }
+    return buffer;
+}
+
+static inline double* lean_yoga_LayoutBuffer_column(b_lean_obj_arg buffer, size_t k) {
+    return lean_float_array_cptr(lean_ctor_get(buffer, k));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Node_exportLayout(b_lean_obj_arg node, lean_obj_arg world) {
+    lean_yoga_LayoutColumns c = { 0 };
+    lean_yoga_LayoutColumns_collect(&c, node);
+    lean_object* buffer = lean_yoga_LayoutBuffer_alloc(c.size);
+    for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+        double* dst = lean_yoga_LayoutBuffer_column(buffer, k);
+        const float* src = c.columns[k];
+        for (size_t i = 0; i < c.size; ++i) {
+            dst[i] = src[i];
+        }
+    }
+    lean_yoga_LayoutColumns_free(&c);
+    return lean_io_result_mk_ok(buffer);
+}
+
+/// Start and end layouts of the union of the nodes of two captures, matched by identity.
+typedef struct {
+    // Slots of the start capture come first
+    size_t startCount;
+    lean_yoga_LayoutColumns start; // nodes owned
+    lean_yoga_LayoutColumns end;   // nodes unused
+} lean_yoga_LayoutAnimation;
+
+static void lean_yoga_LayoutAnimation_clear(lean_yoga_LayoutAnimation* a) {
+    for (size_t i = 0; i < a->start.size; ++i) {
+        lean_dec_ref(a->start.nodes[i]);
+    }
+    lean_yoga_LayoutColumns_free(&a->start);
+    lean_yoga_LayoutColumns_free(&a->end);
+    *a = (lean_yoga_LayoutAnimation){ 0 };
+}
+
+static void lean_yoga_LayoutAnimation_finalizer(void* anim) {
+    lean_yoga_LayoutAnimation_clear(anim);
+    free(anim);
+}
+
+static void lean_yoga_LayoutAnimation_foreach(void* anim, b_lean_obj_arg f) {
+    lean_yoga_LayoutAnimation* a = anim;
+    for (size_t i = 0; i < a->start.size; ++i) {
+        lean_inc_ref(f);
+        lean_inc_ref(a->start.nodes[i]);
+        lean_apply_1(f, a->start.nodes[i]);
+    }
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutAnimation_new(lean_obj_arg world) {
+    lean_yoga_LayoutAnimation* a = calloc(1, sizeof(lean_yoga_LayoutAnimation));
+    return lean_io_result_mk_ok(lean_alloc_external(lean_yoga_LayoutAnimation_class, a));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutAnimation_captureStart(
+    b_lean_obj_arg anim, b_lean_obj_arg root, lean_obj_arg world
+) {
+    lean_yoga_LayoutAnimation* a = lean_get_external_data(anim);
+    lean_yoga_LayoutAnimation_clear(a);
+    lean_yoga_LayoutColumns_collect(&a->start, root);
+    for (size_t i = 0; i < a->start.size; ++i) {
+        lean_inc_ref(a->start.nodes[i]);
+    }
+    a->startCount = a->start.size;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+static inline size_t lean_yoga_ptrHash(const void* p, size_t mask) {
+    uint64_t x = (uintptr_t)p;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return x & mask;
+}
+
+/// Matches the end capture against the start one; nodes missing from either fade in or out in place.
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutAnimation_captureEnd(
+    b_lean_obj_arg anim, b_lean_obj_arg root, lean_obj_arg world
+) {
+    lean_yoga_LayoutAnimation* a = lean_get_external_data(anim);
+    // Drop the slots appended by a previous end capture
+    for (size_t i = a->startCount; i < a->start.size; ++i) {
+        lean_dec_ref(a->start.nodes[i]);
+    }
+    a->start.size = a->startCount;
+    lean_yoga_LayoutColumns_free(&a->end);
+    a->end = (lean_yoga_LayoutColumns){ 0 };
+
+    lean_yoga_LayoutColumns captured = { 0 };
+    lean_yoga_LayoutColumns_collect(&captured, root);
+
+    // Open addressing from node to start slot
+    size_t tableSize = 16;
+    while (tableSize < 2 * (a->startCount + 1)) tableSize *= 2;
+    size_t* table = malloc(tableSize * sizeof(size_t));
+    memset(table, 0xFF, tableSize * sizeof(size_t));
+    for (size_t i = 0; i < a->startCount; ++i) {
+        size_t h = lean_yoga_ptrHash(a->start.nodes[i], tableSize - 1);
+        while (table[h] != SIZE_MAX) h = (h + 1) & (tableSize - 1);
+        table[h] = i;
+    }
+
+    for (size_t i = 0; i < a->startCount; ++i) {
+        // Disappearing unless matched below
+        lean_yoga_LayoutColumns_push(
+            &a->end, a->start.nodes[i],
+            a->start.columns[0][i], a->start.columns[1][i], a->start.columns[2][i], a->start.columns[3][i]
+        );
+        a->end.columns[4][i] = 0;
+    }
+    for (size_t j = 0; j < captured.size; ++j) {
+        lean_object* node = captured.nodes[j];
+        size_t h = lean_yoga_ptrHash(node, tableSize - 1);
+        size_t slot = SIZE_MAX;
+        while (table[h] != SIZE_MAX) {
+            if (a->start.nodes[table[h]] == node) {
+                slot = table[h];
+                break;
+            }
+            h = (h + 1) & (tableSize - 1);
+        }
+        float left = captured.columns[0][j], top = captured.columns[1][j];
+        float width = captured.columns[2][j], height = captured.columns[3][j];
+        if (slot == SIZE_MAX) {
+            // Appearing
+            lean_inc_ref(node);
+            lean_yoga_LayoutColumns_push(&a->start, node, left, top, width, height);
+            a->start.columns[4][a->start.size - 1] = 0;
+            lean_yoga_LayoutColumns_push(&a->end, node, left, top, width, height);
+        }
+        else {
+            a->end.columns[0][slot] = left;
+            a->end.columns[1][slot] = top;
+            a->end.columns[2][slot] = width;
+            a->end.columns[3][slot] = height;
+            a->end.columns[4][slot] = 1;
+        }
+    }
+    free(table);
+    lean_yoga_LayoutColumns_free(&captured);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutAnimation_getNodes(b_lean_obj_arg anim, lean_obj_arg world) {
+    lean_yoga_LayoutAnimation* a = lean_get_external_data(anim);
+    lean_object* nodes = lean_alloc_array(a->start.size, a->start.size);
+    for (size_t i = 0; i < a->start.size; ++i) {
+        lean_inc_ref(a->start.nodes[i]);
+        lean_array_cptr(nodes)[i] = a->start.nodes[i];
+    }
+    return lean_io_result_mk_ok(nodes);
+}
+
+static inline float lean_yoga_ease(uint8_t easing, float t) {
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    switch (easing) {
+        case 1: return t * t * t;
+        case 2: { float u = 1 - t; return 1 - u * u * u; }
+        case 3: {
+            if (t < 0.5f) return 4 * t * t * t;
+            float u = -2 * t + 2;
+            return 1 - u * u * u / 2;
+        }
+        default: return t;
+    }
+}
+
+/// Interpolates every column in one pass; the inner loops are plain float streams the compiler can vectorize.
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutAnimation_sample(
+    b_lean_obj_arg anim, uint32_t t, uint8_t easing, lean_obj_arg world
+) {
+    lean_yoga_LayoutAnimation* a = lean_get_external_data(anim);
+    size_t size = a->end.size == a->start.size ? a->start.size : 0;
+    float e = lean_yoga_ease(easing, lean_pod_Float32_fromBits(t));
+    lean_object* buffer = lean_yoga_LayoutBuffer_alloc(size);
+    for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+        const float* restrict from = a->start.columns[k];
+        const float* restrict to = a->end.columns[k];
+        double* restrict dst = lean_yoga_LayoutBuffer_column(buffer, k);
+        for (size_t i = 0; i < size; ++i) {
+            dst[i] = from[i] + (to[i] - from[i]) * e;
+        }
+    }
+    return lean_io_result_mk_ok(buffer);
+}
+
+static inline double lean_yoga_snapScaled(double value) {
+    // `YGRoundValueToPixelGrid` without forced ceil or floor: fractions within 0.0001 below 0.5 round up
+    double whole = floor(value);
+    return whole + (double)(value - whole > 0.4999);
+}
+
+/// Snaps absolute edges, so that adjacent rectangles stay adjacent, and derives sizes from them.
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutBuffer_roundToPixelGrid(lean_obj_arg buffer, double pointScaleFactor) {
+    if (pointScaleFactor == 0 || isnan(pointScaleFactor)) {
+        return buffer;
+    }
+    if (!lean_is_exclusive(buffer)) {
+        lean_object* copy = lean_alloc_ctor(0, LEAN_YOGA_LAYOUT_COLUMNS, 0);
+        for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+            lean_object* column = lean_ctor_get(buffer, k);
+            lean_inc(column);
+            lean_ctor_set(copy, k, column);
+        }
+        lean_dec_ref(buffer);
+        buffer = copy;
+    }
+    size_t size = SIZE_MAX;
+    for (size_t k = 0; k < 4; ++k) {
+        lean_object* column = lean_ctor_get(buffer, k);
+        if (!lean_is_exclusive(column)) {
+            lean_ctor_set(buffer, k, lean_copy_float_array(column));
+        }
+        size_t columnSize = lean_sarray_size(lean_ctor_get(buffer, k));
+        size = columnSize < size ? columnSize : size;
+    }
+    double* restrict left = lean_yoga_LayoutBuffer_column(buffer, 0);
+    double* restrict top = lean_yoga_LayoutBuffer_column(buffer, 1);
+    double* restrict width = lean_yoga_LayoutBuffer_column(buffer, 2);
+    double* restrict height = lean_yoga_LayoutBuffer_column(buffer, 3);
+    const double scale = pointScaleFactor;
+    for (size_t i = 0; i < size; ++i) {
+        double x0 = lean_yoga_snapScaled(left[i] * scale);
+        double x1 = lean_yoga_snapScaled((left[i] + width[i]) * scale);
+        double y0 = lean_yoga_snapScaled(top[i] * scale);
+        double y1 = lean_yoga_snapScaled((top[i] + height[i]) * scale);
+        left[i] = x0 / scale;
+        top[i] = y0 / scale;
+        width[i] = (x1 - x0) / scale;
+        height[i] = (y1 - y0) / scale;
+    }
+    return buffer;
+}
+
+#define LEAN_YOGA_LAYOUT_STORE_FRESH 4
+
+/// Triple buffer of layouts with a single writer and a single reader, neither of which ever waits.
+typedef struct {
+    lean_yoga_LayoutColumns slots[3];
+    uint64_t generations[3];
+    // Index of the published slot, with `LEAN_YOGA_LAYOUT_STORE_FRESH` set until the reader takes it
+    _Atomic uint32_t middle;
+    // Owned by the writer
+    uint32_t back;
+    uint64_t generation;
+    // Owned by the reader
+    uint32_t front;
+} lean_yoga_LayoutStore;
+
+static void lean_yoga_LayoutStore_finalizer(void* store) {
+    lean_yoga_LayoutStore* s = store;
+    for (size_t i = 0; i < 3; ++i) {
+        lean_yoga_LayoutColumns_free(&s->slots[i]);
+    }
+    free(s);
+}
+
+static void lean_yoga_LayoutStore_foreach(void* store, b_lean_obj_arg f) {}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutStore_new(lean_obj_arg world) {
+    lean_yoga_LayoutStore* s = calloc(1, sizeof(lean_yoga_LayoutStore));
+    s->front = 0;
+    atomic_init(&s->middle, 1);
+    s->back = 2;
+    return lean_io_result_mk_ok(lean_alloc_external(lean_yoga_LayoutStore_class, s));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutStore_publish(
+    b_lean_obj_arg store, b_lean_obj_arg root, lean_obj_arg world
+) {
+    lean_yoga_LayoutStore* s = lean_get_external_data(store);
+    lean_yoga_LayoutColumns* back = &s->slots[s->back];
+    back->size = 0;
+    lean_yoga_LayoutColumns_collect(back, root);
+    s->generations[s->back] = ++s->generation;
+    s->back = atomic_exchange(&s->middle, s->back | LEAN_YOGA_LAYOUT_STORE_FRESH)
+        & ~(uint32_t)LEAN_YOGA_LAYOUT_STORE_FRESH;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutStore_calculateLayout(
+    b_lean_obj_arg store, b_lean_obj_arg root,
+    uint32_t ownerWidth, uint32_t ownerHeight, uint8_t ownerDir, lean_obj_arg world
+) {
+    lean_yoga_calculateLayout(
+        lean_yoga_Node_unbox(root),
+        lean_pod_Float32_fromBits(ownerWidth),
+        lean_pod_Float32_fromBits(ownerHeight),
+        ownerDir
+    );
+    return lean_yoga_LayoutStore_publish(store, root, world);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutStore_acquire(b_lean_obj_arg store, lean_obj_arg world) {
+    lean_yoga_LayoutStore* s = lean_get_external_data(store);
+    if (atomic_load(&s->middle) & LEAN_YOGA_LAYOUT_STORE_FRESH) {
+        s->front = atomic_exchange(&s->middle, s->front) & ~(uint32_t)LEAN_YOGA_LAYOUT_STORE_FRESH;
+    }
+    return lean_io_result_mk_ok(lean_box_uint64(s->generations[s->front]));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutStore_read(b_lean_obj_arg store, lean_obj_arg world) {
+    lean_yoga_LayoutStore* s = lean_get_external_data(store);
+    const lean_yoga_LayoutColumns* front = &s->slots[s->front];
+    lean_object* buffer = lean_yoga_LayoutBuffer_alloc(front->size);
+    for (size_t k = 0; k < LEAN_YOGA_LAYOUT_COLUMNS; ++k) {
+        double* dst = lean_yoga_LayoutBuffer_column(buffer, k);
+        const float* src = front->columns[k];
+        for (size_t i = 0; i < front->size; ++i) {
+            dst[i] = src[i];
+        }
+    }
+    return lean_io_result_mk_ok(buffer);
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_LayoutStore_getRect(
+    b_lean_obj_arg store, uint32_t index, lean_obj_arg world
+) {
+    lean_yoga_LayoutStore* s = lean_get_external_data(store);
+    const lean_yoga_LayoutColumns* front = &s->slots[s->front];
+    if (index >= front->size) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    lean_object* rect = lean_alloc_ctor(0, 0, 4 * sizeof(uint32_t));
+    for (size_t k = 0; k < 4; ++k) {
+        lean_ctor_set_uint32(rect, k * sizeof(uint32_t), lean_pod_Float32_toBits(front->columns[k][index]));
+    }
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, rect);
+    return lean_io_result_mk_ok(some);
+}
+
+// # Arenas
+
+static void lean_yoga_Arena_freeChunks(lean_yoga_Arena* arena) {
+    while (arena->chunks != NULL) {
+        lean_yoga_ArenaChunk* next = arena->chunks->next;
+        free(arena->chunks);
+        arena->chunks = next;
+    }
+}
+
+static void lean_yoga_Arena_finalizer(void* arena) {
+    lean_yoga_Arena* a = arena;
+    // Unreleased or escaped nodes still allocate from the arena, it is leaked with them
+    if (a->nodeCount > 0) {
+        return;
+    }
+    free(a->nodes);
+    free(a);
+}
+
+static void lean_yoga_Arena_foreach(void* arena, b_lean_obj_arg f) {}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Arena_new(lean_obj_arg world) {
+    lean_yoga_Arena* a = calloc(1, sizeof(lean_yoga_Arena));
+    return lean_io_result_mk_ok(lean_alloc_external(lean_yoga_Arena_class, a));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_Arena_newNode(
+    b_lean_obj_arg arena, lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg world
+) {
+    lean_yoga_Arena* a = lean_get_external_data(arena);
+    if (a->released) {
+        lean_dec(ctxVal);
+        lean_dec_ref(cfg);
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga Arena.newNode: the arena was released"
+        )));
+    }
+    YGNodeRef node = lean_yoga_placeYGNode(
+        lean_yoga_Arena_alloc(a, lean_yoga_sizeofYGNode()), lean_yoga_Config_unbox(cfg)
+    );
+    lean_yoga_Node_context* ctx = lean_yoga_Arena_alloc(a, sizeof(lean_yoga_Node_context));
+    *ctx = (lean_yoga_Node_context){ .value = ctxVal, .config = cfg, .arena = a };
+    lean_object* obj = lean_alloc_external(lean_yoga_ArenaNode_class, node);
+    ctx->self = obj;
+    YGNodeSetContext(node, ctx);
+    lean_yoga_countLive(&lean_yoga_liveNodes, 1);
+    if (a->nodeCount == a->nodeCapacity) {
+        a->nodeCapacity = 2 * a->nodeCapacity + 64;
+        a->nodes = realloc(a->nodes, a->nodeCapacity * sizeof(lean_object*));
+    }
+    a->nodes[a->nodeCount++] = obj;
+    lean_inc_ref(obj);
+    return lean_io_result_mk_ok(obj);
+}
+
+/// Frees every node of the arena at once, unless one is still referenced from outside the arena's trees.
+LEAN_EXPORT lean_obj_res lean_yoga_Arena_release(b_lean_obj_arg arena, lean_obj_arg world) {
+    lean_yoga_Arena* a = lean_get_external_data(arena);
+    if (a->released) {
+        return lean_io_result_mk_ok(lean_box(0));
+    }
+    a->released = true;
+    // Each node is referenced by the arena and by its parent, if any
+    size_t escaped = 0;
+    for (size_t i = 0; i < a->nodeCount; ++i) {
+        lean_object* obj = a->nodes[i];
+        int expected = 1 + (lean_yoga_Node_context_of(obj)->parent != NULL);
+        escaped += !lean_is_st(obj) || obj->m_rc != expected;
+    }
+    if (escaped > 0) {
+        char message[128];
+        snprintf(
+            message, sizeof(message),
+            "Yoga withArena: %zu node(s) are referenced after the scope, the arena is leaked", escaped
+        );
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(message)));
+    }
+    for (size_t i = 0; i < a->nodeCount; ++i) {
+        YGNodeRef node = lean_yoga_Node_unbox(a->nodes[i]);
+        lean_yoga_Node_context* ctx = YGNodeGetContext(node);
+        lean_dec(ctx->value);
+        lean_dec_ref(ctx->config);
+        if (ctx->styleClass != NULL) {
+            lean_yoga_StyleClass_unlink(ctx);
+        }
+        lean_yoga_Node_releaseCallbacks(node, ctx);
+    }
+    for (size_t i = 0; i < a->nodeCount; ++i) {
+        lean_object* obj = a->nodes[i];
+        // The context lives in the arena, but is only reachable through the node
+        bool hasParent = lean_yoga_Node_context_of(obj)->parent != NULL;
+        lean_yoga_destroyYGNode(lean_yoga_Node_unbox(obj));
+        if (hasParent) {
+            lean_dec_ref(obj);
+        }
+        lean_dec_ref(obj);
+    }
+    lean_yoga_countLive(&lean_yoga_liveNodes, -(int64_t)a->nodeCount);
+    lean_yoga_Arena_freeChunks(a);
+    free(a->nodes);
+    a->nodes = NULL;
+    a->nodeCount = 0;
+    a->nodeCapacity = 0;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+// # Tree builder
+
+typedef struct {
+    lean_object* ctxVal;
+    lean_object* config;
+    // Keyed measure function of the leaves
+    lean_object* measure;
+    // Open nodes from the root down, not owned
+    lean_object** open;
+    size_t depth;
+    size_t capacity;
+    // Owned from the moment it is opened until `finish`
+    lean_object* root;
+    bool finished;
+} lean_yoga_TreeBuilder;
+
+static void lean_yoga_TreeBuilder_release(lean_yoga_TreeBuilder* b) {
+    lean_dec(b->ctxVal);
+    lean_dec_ref(b->config);
+    lean_dec_ref(b->measure);
+    if (b->root != NULL) {
+        lean_dec_ref(b->root);
+    }
+    free(b->open);
+    *b = (lean_yoga_TreeBuilder){ .finished = true };
+}
+
+static void lean_yoga_TreeBuilder_finalizer(void* builder) {
+    lean_yoga_TreeBuilder* b = builder;
+    if (!b->finished) {
+        lean_yoga_TreeBuilder_release(b);
+    }
+    free(b);
+}
+
+static void lean_yoga_TreeBuilder_foreach(void* builder, b_lean_obj_arg f) {
+    lean_yoga_TreeBuilder* b = builder;
+    if (b->finished) {
+        return;
+    }
+    lean_object* objects[4] = { b->ctxVal, b->config, b->measure, b->root };
+    for (size_t i = 0; i < 4; ++i) {
+        if (objects[i] != NULL) {
+            lean_inc_ref(f);
+            lean_inc(objects[i]);
+            lean_apply_1(f, objects[i]);
+        }
+    }
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_TreeBuilder_new(
+    lean_obj_arg ctxVal, lean_obj_arg cfg, lean_obj_arg measure, lean_obj_arg world
+) {
+    lean_yoga_TreeBuilder* b = malloc(sizeof(lean_yoga_TreeBuilder));
+    *b = (lean_yoga_TreeBuilder){ .ctxVal = ctxVal, .config = cfg, .measure = measure };
+    return lean_io_result_mk_ok(lean_alloc_external(lean_yoga_TreeBuilder_class, b));
+}
+
+/// Whether another node can be added: inside an open node, or as the root of an empty builder.
+static inline bool lean_yoga_TreeBuilder_canAdd(lean_yoga_TreeBuilder* b) {
+    return !b->finished && (b->depth > 0 || b->root == NULL);
+}
+
+/// Creates a node and appends it to the innermost open node, or makes it the root.
+static lean_object* lean_yoga_TreeBuilder_add(lean_yoga_TreeBuilder* b, b_lean_obj_arg style) {
+    lean_inc(b->ctxVal);
+    lean_inc_ref(b->config);
+    lean_object* node = lean_yoga_Node_alloc(b->ctxVal, b->config);
+    YGNodeRef ygNode = lean_yoga_Node_unbox(node);
+    lean_yoga_Style_set(ygNode, lean_yoga_Style_unbox(style));
+    if (b->depth == 0) {
+        b->root = node;
+        return node;
+    }
+    lean_object* parent = b->open[b->depth - 1];
+    YGNodeRef ygParent = lean_yoga_Node_unbox(parent);
+    lean_yoga_Node_context* parentCtx = YGNodeGetContext(ygParent);
+    uint32_t index = YGNodeGetChildCount(ygParent);
+    lean_yoga_Node_reserveChildren(parentCtx, index, index + 1);
+    parentCtx->children[index] = node;
+    lean_yoga_Node_context_of(node)->parent = parent;
+    lean_yoga_Node_context_of(node)->index = index;
+    YGNodeInsertChild(ygParent, ygNode, index);
+    return node;
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_TreeBuilder_openNode(
+    b_lean_obj_arg builder, b_lean_obj_arg style, lean_obj_arg world
+) {
+    lean_yoga_TreeBuilder* b = lean_get_external_data(builder);
+    if (!lean_yoga_TreeBuilder_canAdd(b)) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga TreeBuilder.openNode: the tree is already complete"
+        )));
+    }
+    lean_object* node = lean_yoga_TreeBuilder_add(b, style);
+    if (b->depth == b->capacity) {
+        b->capacity = 2 * b->capacity + 16;
+        b->open = realloc(b->open, b->capacity * sizeof(lean_object*));
+    }
+    b->open[b->depth++] = node;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_TreeBuilder_leaf(
+    b_lean_obj_arg builder, b_lean_obj_arg style, uint64_t measureKey, lean_obj_arg world
+) {
+    lean_yoga_TreeBuilder* b = lean_get_external_data(builder);
+    if (!lean_yoga_TreeBuilder_canAdd(b)) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga TreeBuilder.leaf: the tree is already complete"
+        )));
+    }
+    lean_object* node = lean_yoga_TreeBuilder_add(b, style);
+    lean_yoga_Node_context* ctx = lean_yoga_Node_context_of(node);
+    lean_inc_ref(b->measure);
+    ctx->measureFunc = b->measure;
+    ctx->measureKey = measureKey;
+    ctx->measureKeyed = true;
+    YGNodeSetMeasureFunc(lean_yoga_Node_unbox(node), lean_yoga_measureFunc);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_TreeBuilder_closeNode(b_lean_obj_arg builder, lean_obj_arg world) {
+    lean_yoga_TreeBuilder* b = lean_get_external_data(builder);
+    if (b->depth == 0) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            "Yoga TreeBuilder.closeNode: no node is open"
+        )));
+    }
+    b->depth -= 1;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res lean_yoga_TreeBuilder_finish(b_lean_obj_arg builder, lean_obj_arg world) {
+    lean_yoga_TreeBuilder* b = lean_get_external_data(builder);
+    if (b->finished || b->depth > 0 || b->root == NULL) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(
+            b->finished ? "Yoga TreeBuilder.finish: already finished"
+            : b->depth > 0 ? "Yoga TreeBuilder.finish: nodes are still open"
+            : "Yoga TreeBuilder.finish: the tree is empty"
+        )));
+    }
+    lean_object* root = b->root;
+    b->root = NULL;
+    lean_yoga_TreeBuilder_release(b);
+    return lean_io_result_mk_ok(root);
+}
+
 // # Tests
 
 #ifndef LEAN_YOGA_SKIP_TESTS
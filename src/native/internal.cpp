@@ -0,0 +1,130 @@
+// Parts of the bindings which need Yoga's C++ internals, forwarding to `ffi.c`.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <yoga/YGConfig.h>
+#include <yoga/YGNode.h>
+#include <yoga/Yoga.h>
+#ifdef LEAN_YOGA_EVENTS
+#include <yoga/event/event.h>
+#endif
+
+extern "C" {
+
+size_t lean_yoga_sizeofYGNode(void) {
+    return sizeof(YGNode);
+}
+
+size_t lean_yoga_sizeofYGConfig(void) {
+    return sizeof(YGConfig);
+}
+
+/// Constructs a node in memory owned by an arena, see `lean_yoga_Arena_newNode`.
+YGNodeRef lean_yoga_placeYGNode(void* memory, YGConfigRef config) {
+    return new (memory) YGNode{config};
+}
+
+/// Destroys a node made by `lean_yoga_placeYGNode` without touching its owner or children.
+void lean_yoga_destroyYGNode(YGNodeRef node) {
+    node->~YGNode();
+}
+
+/// Replaces the children of a node at once, dirtying it once.
+/// Unlike `YGNodeSetChildren` the children to detach are given instead of searched for.
+void lean_yoga_setChildren(
+    YGNodeRef node, const YGNodeRef* children, size_t count, const YGNodeRef* detached, size_t detachedCount
+) {
+    for (size_t i = 0; i < detachedCount; ++i) {
+        detached[i]->setLayout(YGLayout{});
+        detached[i]->setOwner(nullptr);
+    }
+    node->setChildren(YGVector(children, children + count));
+    for (size_t i = 0; i < count; ++i) {
+        children[i]->setOwner(node);
+    }
+    node->markDirtyAndPropagate();
+}
+
+/// Dirties a node and its ancestors, unlike `YGNodeMarkDirty` also without a measure function.
+void lean_yoga_markDirtyAndPropagate(YGNodeRef node) {
+    node->markDirtyAndPropagate();
+}
+
+/// The layout pass which last visited a node, the same for all nodes visited by one pass.
+uint32_t lean_yoga_layoutGeneration(YGNodeRef node) {
+    return node->getLayout().generationCount;
+}
+
+/// Writes a layout stored by `Node.saveSnapshot` into a node, as both its layout and measured size.
+void lean_yoga_restoreLayout(YGNodeRef node, float left, float top, float width, float height) {
+    node->setLayoutPosition(left, YGEdgeLeft);
+    node->setLayoutPosition(top, YGEdgeTop);
+    node->setLayoutDimension(width, YGDimensionWidth);
+    node->setLayoutDimension(height, YGDimensionHeight);
+    node->setLayoutMeasuredDimension(width, YGDimensionWidth);
+    node->setLayoutMeasuredDimension(height, YGDimensionHeight);
+}
+
+/// Marks a node with a restored layout as laid out in `direction`, so Yoga won't revisit it.
+void lean_yoga_markRestored(YGNodeRef node, YGDirection direction, YGDirection ownerDirection) {
+    node->setLayoutDirection(direction);
+    node->setLayoutLastOwnerDirection(ownerDirection);
+    node->setDirty(false);
+    node->setHasNewLayout(false);
+}
+
+/// The available size and measure modes a root was last laid out with.
+void lean_yoga_getCachedLayout(
+    YGNodeRef node, float* availableWidth, float* availableHeight, uint8_t* widthMode, uint8_t* heightMode
+) {
+    const YGCachedMeasurement& cached = node->getLayout().cachedLayout;
+    *availableWidth = cached.availableWidth;
+    *availableHeight = cached.availableHeight;
+    *widthMode = static_cast<uint8_t>(cached.widthMeasureMode);
+    *heightMode = static_cast<uint8_t>(cached.heightMeasureMode);
+}
+
+/// Makes the next layout of a restored root with the same available size hit its cache.
+void lean_yoga_setCachedLayout(
+    YGNodeRef node, float availableWidth, float availableHeight, uint8_t widthMode, uint8_t heightMode
+) {
+    YGCachedMeasurement& cached = node->getLayout().cachedLayout;
+    cached.availableWidth = availableWidth;
+    cached.availableHeight = availableHeight;
+    cached.widthMeasureMode = static_cast<YGMeasureMode>(widthMode);
+    cached.heightMeasureMode = static_cast<YGMeasureMode>(heightMode);
+    cached.computedWidth = YGNodeLayoutGetWidth(node);
+    cached.computedHeight = YGNodeLayoutGetHeight(node);
+}
+
+#ifdef LEAN_YOGA_EVENTS
+void lean_yoga_events_onLayoutPassStart(YGNodeRef root);
+void lean_yoga_events_onNodeLayout(YGNodeRef node, int layoutType);
+void lean_yoga_events_onMeasureCallbackEnd(YGNodeRef node);
+
+/// Events are only published when Yoga itself is built with `YG_ENABLE_EVENTS`.
+void lean_yoga_events_subscribe(void) {
+    using facebook::yoga::Event;
+    Event::subscribe([](const YGNode& node, Event::Type type, Event::Data data) {
+        YGNodeRef ref = const_cast<YGNodeRef>(&node);
+        switch (type) {
+            case Event::LayoutPassStart:
+                lean_yoga_events_onLayoutPassStart(ref);
+                break;
+            case Event::NodeLayout:
+                lean_yoga_events_onNodeLayout(
+                    ref, static_cast<int>(data.get<Event::NodeLayout>().layoutType)
+                );
+                break;
+            case Event::MeasureCallbackEnd:
+                lean_yoga_events_onMeasureCallbackEnd(ref);
+                break;
+            default:
+                break;
+        }
+    });
+}
+#endif
+
+}